@@ -0,0 +1,159 @@
+#include "Alerts/AlertEngine.h"
+
+#include "Tracing/Tracer.h"
+#include "Utils.h"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+const size_t MAX_OUT_QUEUE_SIZE = 2;
+
+// eyes closed : raised after EYES_CLOSED_RAISE_DELAY seconds with eyes closed (see DriverStateStage)
+const double EYES_CLOSED_RAISE_DELAY = 0.8;
+const double EYES_CLOSED_CLEAR_DELAY = 0.3;
+
+// no face : boxes older than NO_FACE_MAX_DETECTION_AGE seconds are from a face that is gone
+const double NO_FACE_MAX_DETECTION_AGE = 0.3;
+const double NO_FACE_RAISE_DELAY = 1.5;
+const double NO_FACE_CLEAR_DELAY = 0.5;
+
+// head turned : raised above HEAD_TURNED_RAISE_YAW degrees, cleared below HEAD_TURNED_CLEAR_YAW degrees
+const float HEAD_TURNED_RAISE_YAW = 30.f;
+const float HEAD_TURNED_CLEAR_YAW = 20.f;
+const double HEAD_TURNED_RAISE_DELAY = 1.5;
+const double HEAD_TURNED_CLEAR_DELAY = 0.5;
+
+// not a Scheduler thread
+const int ALERT_ENGINE_THREAD_ID = -2;
+
+// latency samples kept for the report
+const size_t LATENCIES_CAPACITY = 8192;
+
+AlertEngine::AlertEngine(std::shared_ptr<SharedQueue<FaceResultsPtr>> inFaceFeatures,
+                         std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures,
+                         std::shared_ptr<IAlertSink> sink)
+    : m_inFaceFeatures(inFaceFeatures),
+      m_outFaceFeatures(outFaceFeatures),
+      m_sink(sink),
+      m_eyesClosed({AlertType::EyesClosed, EYES_CLOSED_RAISE_DELAY, EYES_CLOSED_CLEAR_DELAY, false, -1.}),
+      m_noFace({AlertType::NoFace, NO_FACE_RAISE_DELAY, NO_FACE_CLEAR_DELAY, false, -1.}),
+      m_headTurned({AlertType::HeadTurned, HEAD_TURNED_RAISE_DELAY, HEAD_TURNED_CLEAR_DELAY, false, -1.}),
+      m_lastTimestamp(0.),
+      m_decisionLatencies(LATENCIES_CAPACITY),
+      m_alertLatencies(LATENCIES_CAPACITY),
+      m_mutex(),
+      m_thread()
+{
+    m_thread = std::thread(&AlertEngine::run, this);
+}
+
+AlertEngine::~AlertEngine() {
+    stop();
+}
+
+void AlertEngine::stop() {
+    if (!m_thread.joinable())
+        return;
+
+    // an empty result tells the thread to stop
+    m_inFaceFeatures->push_back(FaceResultsPtr());
+    m_thread.join();
+}
+
+void AlertEngine::run() {
+    Tracer::instance().setThreadName("alert engine");
+
+    FaceResultsPtr faces;
+    for (;;) {
+        m_inFaceFeatures->pop_front_wait(faces);
+        if (!faces)
+            return;
+
+        // results computed in parallel may come out of order, the older ones are too late to matter
+        if (faces->frame.timestamp >= m_lastTimestamp) {
+            m_lastTimestamp = faces->frame.timestamp;
+
+            const double start = timeNow();
+            TRACE_SPAN("alerts");
+            evaluate(*faces);
+            faces->setStageTiming(STAGE_ALERTS, timeNow() - start, ALERT_ENGINE_THREAD_ID);
+
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_decisionLatencies.push_back(timeNow() - faces->frame.timestamp);
+        }
+
+        m_outFaceFeatures->push_back(std::move(faces));
+
+        if (m_outFaceFeatures->size() > MAX_OUT_QUEUE_SIZE)
+            m_outFaceFeatures->pop_front_no_wait();
+    }
+}
+
+void AlertEngine::evaluate(const FaceResults& faces) {
+    const DriverState& state = faces.driverState;
+    const double timestamp = faces.frame.timestamp;
+
+    const double detection_age = timestamp - faces.detectionTimestamp;
+    const bool no_face = !state.valid || detection_age > NO_FACE_MAX_DETECTION_AGE;
+    update(m_noFace, no_face, static_cast<float>(detection_age), faces);
+
+    const bool eyes_closed = !no_face && state.eyesClosed;
+    update(m_eyesClosed, eyes_closed, static_cast<float>(state.eyesClosedDuration), faces);
+
+    // without head pose, the head is considered where it was
+    if (!no_face && faces.hasHeadPose[state.face]) {
+        const float yaw = faces.headYaw[state.face];
+        const float threshold = m_headTurned.active ? HEAD_TURNED_CLEAR_YAW : HEAD_TURNED_RAISE_YAW;
+        update(m_headTurned, std::fabs(yaw) > threshold, yaw, faces);
+    }
+}
+
+void AlertEngine::update(Rule& rule, bool condition, float value, const FaceResults& faces) {
+    const double timestamp = faces.frame.timestamp;
+
+    if (condition == rule.active) {
+        rule.changeSince = -1.;
+        return;
+    }
+
+    if (rule.changeSince < 0.)
+        rule.changeSince = timestamp;
+
+    if (timestamp - rule.changeSince < (condition ? rule.raiseDelay : rule.clearDelay))
+        return;
+
+    rule.active = condition;
+    rule.changeSince = -1.;
+
+    AlertEvent event;
+    event.type = rule.type;
+    event.raised = condition;
+    event.frameId = faces.frame.id;
+    event.captureTimestamp = timestamp;
+    event.value = value;
+    event.emitTimestamp = timeNow();
+    if (m_sink)
+        (*m_sink)(event);
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_alertLatencies.push_back(event.emitTimestamp - event.captureTimestamp);
+}
+
+static void printPercentiles(const char* name, const RingBuffer<double>& latencies) {
+    std::vector<double> values(latencies.size());
+    for (size_t i = 0; i < latencies.size(); ++i)
+        values[i] = latencies[i] * 1000.;
+
+    std::cout << name << " latency (ms) over " << values.size() << " samples :"
+              << " p50 " << percentile(values, 50.)
+              << " p90 " << percentile(values, 90.)
+              << " p99 " << percentile(values, 99.)
+              << " max " << percentile(values, 100.) << std::endl;
+}
+
+void AlertEngine::printLatencyReport() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    printPercentiles("AlertEngine capture to decision", m_decisionLatencies);
+    printPercentiles("AlertEngine capture to alert", m_alertLatencies);
+}
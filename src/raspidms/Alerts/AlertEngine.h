@@ -0,0 +1,97 @@
+#ifndef ALERTENGINE_H
+#define ALERTENGINE_H
+
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "Alerts/IAlertSink.h"
+#include "FaceResults.h"
+#include "RingBuffer.h"
+#include "SharedQueue.h"
+
+/**
+ * @brief The AlertEngine class raises and clears alerts from the driver state of each result :
+ * - eyes closed for too long
+ * - no face detected for too long
+ * - head turned away (large yaw) for too long
+ * Each rule has a hysteresis : its condition must hold for some time before the alert is raised,
+ * and be gone for some time before it is cleared (head yaw also has distinct raise and clear angles).
+ *
+ * It runs on its own thread, woken up as soon as results are pushed to inFaceFeatures,
+ * of which it must be the only consumer. Results are then passed on to outFaceFeatures.
+ *
+ * The capture to decision latency of every result, and the capture to sink latency of every event
+ * are kept, see printLatencyReport().
+ */
+class AlertEngine
+{
+public:
+    AlertEngine(std::shared_ptr<SharedQueue<FaceResultsPtr>> inFaceFeatures,
+                std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures,
+                std::shared_ptr<IAlertSink> sink);
+    AlertEngine(const AlertEngine&) = delete;
+
+    // stops the thread
+    ~AlertEngine();
+
+    /**
+     * @brief stop wait for the results already pushed to be processed, and stop the thread
+     * The stages pushing to inFaceFeatures (and trimming it) must be stopped first :
+     * the thread is told to stop by an empty result pushed behind the others.
+     */
+    void stop();
+
+    /**
+     * @brief printLatencyReport print capture to decision and capture to alert latency percentiles
+     */
+    void printLatencyReport();
+
+private:
+    /**
+     * @brief The Rule struct is an alert state with time hysteresis
+     */
+    struct Rule {
+        AlertType type;
+        double raiseDelay;    // condition must hold that long to raise
+        double clearDelay;    // condition must be gone that long to clear
+        bool active;
+        double changeSince;   // since when the condition differs from active, -1 if it does not
+    };
+
+    void run();
+
+    /**
+     * @brief evaluate update all rules with results, and emit the events
+     * @param faces
+     */
+    void evaluate(const FaceResults& faces);
+
+    /**
+     * @brief update update rule with its condition at faces time, and emit an event if it changed state
+     * @param rule
+     * @param condition
+     * @param value
+     * @param faces
+     */
+    void update(Rule& rule, bool condition, float value, const FaceResults& faces);
+
+    std::shared_ptr<SharedQueue<FaceResultsPtr>> m_inFaceFeatures;
+    std::shared_ptr<SharedQueue<FaceResultsPtr>> m_outFaceFeatures;
+    std::shared_ptr<IAlertSink> m_sink;
+
+    // only used by the engine thread
+    Rule m_eyesClosed;
+    Rule m_noFace;
+    Rule m_headTurned;
+    double m_lastTimestamp;
+
+    // latencies in seconds, guarded by m_mutex
+    RingBuffer<double> m_decisionLatencies;
+    RingBuffer<double> m_alertLatencies;
+    std::mutex m_mutex;
+
+    std::thread m_thread;
+};
+
+#endif // ALERTENGINE_H
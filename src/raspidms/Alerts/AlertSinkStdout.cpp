@@ -0,0 +1,14 @@
+#include "Alerts/AlertSinkStdout.h"
+
+AlertSinkStdout::AlertSinkStdout(std::ostream& stream)
+    : m_stream(stream)
+{
+
+}
+
+void AlertSinkStdout::operator()(const AlertEvent& event) {
+    m_stream << "ALERT " << alertTypeName(event.type) << (event.raised ? " raised" : " cleared")
+             << " frame " << event.frameId
+             << " value " << event.value
+             << " latency " << (event.emitTimestamp - event.captureTimestamp) * 1000. << " ms" << std::endl;
+}
@@ -0,0 +1,25 @@
+#ifndef ALERTSINKSTDOUT_H
+#define ALERTSINKSTDOUT_H
+
+#include <iostream>
+
+#include "Alerts/IAlertSink.h"
+
+/**
+ * @brief The AlertSinkStdout class prints alert events, one line each, to std::cout or another stream
+ */
+class AlertSinkStdout : public IAlertSink
+{
+public:
+    AlertSinkStdout(std::ostream& stream = std::cout);
+
+    /**
+     * override void IAlertSink::operator()(const AlertEvent&);
+     */
+    virtual void operator()(const AlertEvent& event) override;
+
+private:
+    std::ostream& m_stream;
+};
+
+#endif // ALERTSINKSTDOUT_H
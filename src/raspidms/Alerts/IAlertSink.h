@@ -0,0 +1,43 @@
+#ifndef IALERTSINK_H
+#define IALERTSINK_H
+
+enum class AlertType {
+    EyesClosed,
+    NoFace,
+    HeadTurned,
+};
+
+inline const char* alertTypeName(AlertType type) {
+    switch (type) {
+    case AlertType::EyesClosed: return "eyes_closed";
+    case AlertType::NoFace: return "no_face";
+    case AlertType::HeadTurned: return "head_turned";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief AlertEvent is emitted by AlertEngine when an alert is raised, and when it is cleared
+ * Timestamps are in seconds, in the time base of timeNow() (see Utils.h)
+ */
+struct AlertEvent {
+    AlertType type;
+    bool raised;             // false when the alert is cleared
+    long frameId;            // frame that triggered the event
+    double captureTimestamp; // capture time of that frame
+    double emitTimestamp;    // time the event was handed to the sink
+    float value;             // signal that triggered the event (eyes closed duration, seconds without face, yaw)
+};
+
+/**
+ * @brief The IAlertSink class receives the alert events
+ * Called on the AlertEngine thread : must return quickly, as it delays the next events
+ */
+class IAlertSink {
+public:
+    virtual ~IAlertSink() {}
+
+    virtual void operator()(const AlertEvent& event) = 0;
+};
+
+#endif // IALERTSINK_H
@@ -0,0 +1,137 @@
+#include "Batch/BatchRunner.h"
+
+#include "ThreadPool.h"
+#include "Tracing/Tracer.h"
+#include "Utils.h"
+
+#include <iostream>
+#include <thread>
+
+ScopedCpuTime::ScopedCpuTime(StageCpuTimes& times, StageId stage)
+    : m_times(times),
+      m_stage(stage),
+      m_start(threadCpuTime())
+{
+
+}
+
+ScopedCpuTime::~ScopedCpuTime() {
+    m_times.add(m_stage, threadCpuTime() - m_start);
+}
+
+BatchRunner::BatchRunner(int nThreads, int maxInFlight)
+    : m_nThreads(nThreads > 0 ? nThreads : 1),
+      m_maxInFlight(maxInFlight > 0 ? maxInFlight : 1),
+      m_done(),
+      m_inFlight(0),
+      m_numFrames(0),
+      m_endOfSource(false),
+      m_failed(false),
+      m_mutex(),
+      m_doneCv(),
+      m_slotCv()
+{
+
+}
+
+size_t BatchRunner::run(IFrameSource& source, ProcessFunc process, EmitFunc emit) {
+    m_done.clear();
+    m_inFlight = 0;
+    m_numFrames = 0;
+    m_endOfSource = false;
+    m_failed = false;
+
+    ThreadPool pool(m_nThreads);
+    const long funcId = getUniqueId();
+
+    // decode ahead, waiting for a free slot before each frame
+    std::thread decoder([&]() {
+        Tracer::instance().setThreadName("decoder");
+        for (size_t order = 0; ; ++order) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_slotCv.wait(lock, [this]() { return m_inFlight < m_maxInFlight || m_failed; });
+                if (m_failed)
+                    return;
+            }
+
+            Frame frame;
+            bool read = false;
+            {
+                TRACE_SPAN("capture.read");
+                read = source.read(frame);
+            }
+            if (!read) {
+                std::lock_guard<std::mutex> guard(m_mutex);
+                m_numFrames = order;
+                m_endOfSource = true;
+                m_doneCv.notify_all();
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> guard(m_mutex);
+                ++m_inFlight;
+            }
+
+            pool.push(funcId, [this, &process, frame, order](int threadId) {
+                // an exception would end in the discarded future of the task : a null result marks the failure
+                FaceResultsPtr faces;
+                try {
+                    faces = process(frame, threadId);
+                } catch (const std::exception& e) {
+                    std::cerr << "BatchRunner: frame " << order << " failed: " << e.what() << std::endl;
+                } catch (...) {
+                    std::cerr << "BatchRunner: frame " << order << " failed" << std::endl;
+                }
+
+                std::lock_guard<std::mutex> guard(m_mutex);
+                m_done[order] = std::move(faces);
+                m_doneCv.notify_all();
+            });
+        }
+    });
+
+    // emit in order, up to the first failed frame
+    size_t next = 0;
+    for (; ; ++next) {
+        FaceResultsPtr faces;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_doneCv.wait(lock, [this, next]() {
+                return m_done.count(next) > 0 || (m_endOfSource && next >= m_numFrames);
+            });
+
+            auto doneIt = m_done.find(next);
+            if (doneIt == m_done.end())
+                break;
+            faces = std::move(doneIt->second);
+            m_done.erase(doneIt);
+
+            if (!faces) {
+                // the decoder stops, frames already pushed are processed but not emitted
+                m_failed = true;
+                m_slotCv.notify_one();
+                break;
+            }
+        }
+
+        {
+            TRACE_SPAN("emit");
+            emit(std::move(faces));
+        }
+
+        // the slot is only given back once emitted : results waiting for reordering count as in flight
+        std::lock_guard<std::mutex> guard(m_mutex);
+        --m_inFlight;
+        m_slotCv.notify_one();
+    }
+
+    decoder.join();
+    pool.stop(true);
+    return next;
+}
+
+bool BatchRunner::failed() const {
+    return m_failed;
+}
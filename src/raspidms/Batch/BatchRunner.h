@@ -0,0 +1,97 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+
+#include "Capture/IFrameSource.h"
+#include "FaceResults.h"
+
+/**
+ * @brief The StageCpuTimes struct accumulates the CPU time spent in each stage, from any thread
+ */
+struct StageCpuTimes {
+    std::atomic<long long> nanoseconds[NUM_STAGES];
+
+    StageCpuTimes() { for (auto& ns : nanoseconds) ns = 0; }
+
+    void add(StageId stage, double seconds) { nanoseconds[stage] += static_cast<long long>(seconds * 1e9); }
+    double seconds(StageId stage) const { return nanoseconds[stage] * 1e-9; }
+};
+
+/**
+ * @brief The ScopedCpuTime class adds the CPU time of the calling thread during its lifetime to a stage
+ */
+class ScopedCpuTime {
+public:
+    ScopedCpuTime(StageCpuTimes& times, StageId stage);
+    ~ScopedCpuTime();
+
+private:
+    StageCpuTimes& m_times;
+    const StageId m_stage;
+    const double m_start;
+};
+
+/**
+ * @brief The BatchRunner class processes every frame of a source as fast as possible, for offline analysis
+ * - a thread decodes ahead, up to maxInFlight frames
+ * - frames are processed in parallel by "process" on a ThreadPool of nThreads
+ * - results are given to "emit" in frame order, on the thread calling run()
+ * No frame is dropped : decoding waits when too many frames are in flight.
+ * If "process" throws (or returns no result) for a frame, the run stops at that frame : the frames before it
+ * are emitted, none after it, and failed() is true.
+ *
+ * USAGE :
+ * BatchRunner runner(4, 8);
+ * runner.run(source,
+ *            [&](const Frame& frame, int threadId) { return detect(frame, threadId); },
+ *            [&](FaceResultsPtr faces) { analyze(faces); });
+ */
+class BatchRunner
+{
+public:
+    // parallel part, threadId is the one of the ThreadPool thread running it
+    typedef std::function<FaceResultsPtr(const Frame& frame, int threadId)> ProcessFunc;
+
+    // sequential part, called in frame order
+    typedef std::function<void(FaceResultsPtr faces)> EmitFunc;
+
+    BatchRunner(int nThreads, int maxInFlight);
+    BatchRunner(const BatchRunner&) = delete;
+
+    /**
+     * @brief run process all frames of source, returns once they were all emitted, or one failed
+     * @param source
+     * @param process
+     * @param emit
+     * @return number of frames emitted
+     */
+    size_t run(IFrameSource& source, ProcessFunc process, EmitFunc emit);
+
+    /**
+     * @brief failed
+     * @return true if the last run() stopped on a frame that could not be processed
+     */
+    bool failed() const;
+
+private:
+    const int m_nThreads;
+    const int m_maxInFlight;
+
+    // guarded by m_mutex
+    std::map<size_t /*order*/, FaceResultsPtr> m_done;
+    int m_inFlight;
+    size_t m_numFrames;
+    bool m_endOfSource;
+    bool m_failed;
+
+    std::mutex m_mutex;
+    std::condition_variable m_doneCv;
+    std::condition_variable m_slotCv;
+};
+
+#endif // BATCHRUNNER_H
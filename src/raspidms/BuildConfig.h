@@ -0,0 +1,47 @@
+#ifndef BUILDCONFIG_H
+#define BUILDCONFIG_H
+
+/**
+ * Face detector and face mesh compiled in (CMake options RASPIDMS_FACE_DETECTOR and RASPIDMS_FACE_MESH).
+ *
+ * By default, every implementation is compiled in, chosen at runtime by name,
+ * and FaceDetectorType / FaceMeshType are the interfaces.
+ * A single configuration build (one face detector, one face mesh) only compiles the chosen implementations :
+ * FaceDetectorType / FaceMeshType are then these final classes, that the stages call without virtual dispatch
+ * (inlined with link time optimization), and the other implementations (and their libraries) are left out.
+ */
+
+#if defined(RASPIDMS_FACE_DETECTOR_HAAR)
+#include "DetectFaces/DetectFacesHaar.h"
+typedef DetectFacesHaar FaceDetectorType;
+#elif defined(RASPIDMS_FACE_DETECTOR_RESNETCAFFE)
+#include "DetectFaces/DetectFacesResnetCaffe.h"
+typedef DetectFacesResnetCaffe FaceDetectorType;
+#elif defined(RASPIDMS_FACE_DETECTOR_YOLORESNET18) || defined(RASPIDMS_FACE_DETECTOR_YOLOEFFNETB0)
+#include "DetectFaces/DetectFacesMyYolo.h"
+typedef DetectFacesMyYolo FaceDetectorType;
+#elif defined(RASPIDMS_FACE_DETECTOR_HOG)
+#include "DetectFaces/DetectFacesHoG.h"
+typedef DetectFacesHoG FaceDetectorType;
+#elif defined(RASPIDMS_FACE_DETECTOR_MEDIAPIPE)
+#include "DetectFaces/DetectFacesMediaPipe.h"
+typedef DetectFacesMediaPipe FaceDetectorType;
+#else
+#include "DetectFaces/IDetectFaces.h"
+typedef IDetectFaces FaceDetectorType;
+#define RASPIDMS_ALL_FACE_DETECTORS
+#endif
+
+#if defined(RASPIDMS_FACE_MESH_DLIB_68)
+#include "FaceFeatures/FaceFeaturesDlib.h"
+typedef FaceFeaturesDlib FaceMeshType;
+#elif defined(RASPIDMS_FACE_MESH_MEDIAPIPE)
+#include "FaceFeatures/FaceFeaturesMediaPipe.h"
+typedef FaceFeaturesMediaPipe FaceMeshType;
+#else
+#include "FaceFeatures/IFaceFeatures.h"
+typedef IFaceFeatures FaceMeshType;
+#define RASPIDMS_ALL_FACE_MESHES
+#endif
+
+#endif // BUILDCONFIG_H
@@ -0,0 +1,107 @@
+#include "Capture/FrameRecorder.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+
+FrameRecorder::FrameRecorder(const std::string& path, uint32_t capacity)
+    : m_path(path),
+      m_capacity(capacity > 0 ? capacity : 1),
+      m_header(nullptr),
+      m_timestamps(nullptr),
+      m_frames(nullptr),
+      m_mappedSize(0),
+      m_failed(false)
+{
+
+}
+
+FrameRecorder::~FrameRecorder() {
+    if (!m_header)
+        return;
+
+    const size_t used_size = m_header->framesOffset + m_header->numFrames * m_header->frameStride;
+    msync(m_header, m_mappedSize, MS_SYNC);
+    munmap(m_header, m_mappedSize);
+
+    // drop the room left for frames that were not recorded
+    if (truncate(m_path.c_str(), static_cast<off_t>(used_size)) != 0)
+        std::cerr << "FrameRecorder: can't truncate " << m_path << std::endl;
+}
+
+bool FrameRecorder::open(const cv::Mat& image) {
+    const uint64_t frame_size = static_cast<uint64_t>(image.cols) * image.rows * image.elemSize();
+    const uint64_t frames_offset = alignFrameRecording(sizeof(FrameRecordingHeader) + m_capacity * sizeof(double));
+    const uint64_t frame_stride = alignFrameRecording(frame_size);
+    const size_t size = frames_offset + m_capacity * frame_stride;
+
+    const int fd = ::open(m_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "FrameRecorder: can't open " << m_path << std::endl;
+        return false;
+    }
+
+    // sparse : disk space is only used by recorded frames
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        std::cerr << "FrameRecorder: can't resize " << m_path << std::endl;
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "FrameRecorder: can't map " << m_path << std::endl;
+        return false;
+    }
+
+    m_mappedSize = size;
+    m_header = static_cast<FrameRecordingHeader*>(data);
+    m_timestamps = reinterpret_cast<double*>(static_cast<char*>(data) + sizeof(FrameRecordingHeader));
+    m_frames = static_cast<char*>(data) + frames_offset;
+
+    std::memcpy(m_header->magic, FRAME_RECORDING_MAGIC, sizeof(FRAME_RECORDING_MAGIC));
+    m_header->version = FRAME_RECORDING_VERSION;
+    m_header->width = image.cols;
+    m_header->height = image.rows;
+    m_header->type = image.type();
+    m_header->elemSize = static_cast<uint32_t>(image.elemSize());
+    m_header->capacity = m_capacity;
+    m_header->numFrames = 0;
+    m_header->frameStride = frame_stride;
+    m_header->framesOffset = frames_offset;
+    return true;
+}
+
+bool FrameRecorder::record(const Frame& frame) {
+    const cv::Mat& image = frame.image;
+    if (m_failed || image.empty())
+        return false;
+
+    if (!m_header && !open(image)) {
+        m_failed = true;
+        return false;
+    }
+
+    if (m_header->numFrames >= m_capacity
+            || image.cols != m_header->width || image.rows != m_header->height || image.type() != m_header->type)
+        return false;
+
+    const uint64_t index = m_header->numFrames;
+    char* dst = m_frames + index * m_header->frameStride;
+    const size_t row_size = static_cast<size_t>(image.cols) * image.elemSize();
+    if (image.isContinuous()) {
+        std::memcpy(dst, image.data, row_size * image.rows);
+    } else {
+        for (int y = 0; y < image.rows; ++y)
+            std::memcpy(dst + y * row_size, image.ptr(y), row_size);
+    }
+    m_timestamps[index] = frame.timestamp;
+
+    // published last, an interrupted recording stays consistent
+    m_header->numFrames = index + 1;
+    return true;
+}
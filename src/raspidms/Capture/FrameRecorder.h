@@ -0,0 +1,43 @@
+#ifndef FRAMERECORDER_H
+#define FRAMERECORDER_H
+
+#include <string>
+
+#include "Capture/FrameRecordingFormat.h"
+#include "Frame.h"
+
+/**
+ * @brief The FrameRecorder class writes raw frames and their capture timestamps to a memory-mapped file
+ * (see FrameRecordingFormat.h), to be replayed by ReplaySource.
+ * The file is created on the first frame, sized for "capacity" frames of the first frame size,
+ * and truncated to the recorded frames at destruction.
+ * The frame count is updated after each frame, so an interrupted recording keeps the frames written so far.
+ * Not thread safe.
+ */
+class FrameRecorder
+{
+public:
+    FrameRecorder(const std::string& path, uint32_t capacity);
+    FrameRecorder(const FrameRecorder&) = delete;
+    ~FrameRecorder();
+
+    /**
+     * @brief record append frame
+     * @param frame
+     * @return false if the recording is full, can't be created, or frame does not have the size and type of the first one
+     */
+    bool record(const Frame& frame);
+
+private:
+    bool open(const cv::Mat& image);
+
+    const std::string m_path;
+    const uint32_t m_capacity;
+    FrameRecordingHeader* m_header;
+    double* m_timestamps;
+    char* m_frames;
+    size_t m_mappedSize;
+    bool m_failed;
+};
+
+#endif // FRAMERECORDER_H
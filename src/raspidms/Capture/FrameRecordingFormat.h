@@ -0,0 +1,39 @@
+#ifndef FRAMERECORDINGFORMAT_H
+#define FRAMERECORDINGFORMAT_H
+
+#include <cstdint>
+
+/**
+ * Binary layout of the raw frame recordings written by FrameRecorder and replayed by ReplaySource
+ *
+ * The file is a FrameRecordingHeader, followed by "capacity" capture timestamps (double, seconds),
+ * followed by the frames : frame i starts at framesOffset + i * frameStride, its rows are
+ * width * elemSize bytes long and contiguous.
+ * Only the first numFrames frames are valid.
+ * All values are in the native endianness of the writer.
+ */
+
+const char FRAME_RECORDING_MAGIC[8] = {'R', 'D', 'M', 'S', 'R', 'E', 'C', '1'};
+const uint32_t FRAME_RECORDING_VERSION = 1;
+
+// frames start on page boundaries
+const uint64_t FRAME_RECORDING_ALIGNMENT = 4096;
+
+struct FrameRecordingHeader {
+    char magic[8];
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    int32_t type;           // OpenCV type of the frames (CV_8UC3 ...)
+    uint32_t elemSize;      // bytes per pixel
+    uint32_t capacity;
+    uint64_t numFrames;
+    uint64_t frameStride;   // bytes from one frame to the next
+    uint64_t framesOffset;  // bytes from the start of the file to the first frame
+};
+
+inline uint64_t alignFrameRecording(uint64_t size) {
+    return (size + FRAME_RECORDING_ALIGNMENT - 1) / FRAME_RECORDING_ALIGNMENT * FRAME_RECORDING_ALIGNMENT;
+}
+
+#endif // FRAMERECORDINGFORMAT_H
@@ -0,0 +1,21 @@
+#ifndef IFRAMESOURCE_H
+#define IFRAMESOURCE_H
+
+#include "Frame.h"
+
+class IFrameSource {
+public:
+    virtual ~IFrameSource() {}
+
+    virtual bool isOpened() const = 0;
+
+    /**
+     * @brief read wait for the next frame
+     * Each frame has its own image buffer : previous frames may still be in use by the stages
+     * @param frame filled with the image, its id, and the time it was made available (see timeNow())
+     * @return false at the end of the source, or on error
+     */
+    virtual bool read(Frame& frame) = 0;
+};
+
+#endif // IFRAMESOURCE_H
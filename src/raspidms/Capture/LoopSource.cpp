@@ -0,0 +1,37 @@
+#include "Capture/LoopSource.h"
+
+#include "Utils.h"
+
+#include <chrono>
+#include <thread>
+
+LoopSource::LoopSource(const std::vector<cv::Mat>& images, double fps, long maxFrames)
+    : m_images(images),
+      m_period(fps > 0. ? 1. / fps : 0.),
+      m_maxFrames(maxFrames),
+      m_frameId(0),
+      m_startTime(0.)
+{
+
+}
+
+bool LoopSource::isOpened() const {
+    return !m_images.empty();
+}
+
+bool LoopSource::read(Frame& frame) {
+    if (m_images.empty() || (m_maxFrames > 0 && m_frameId >= m_maxFrames))
+        return false;
+
+    const long id = m_frameId++;
+    if (id == 0)
+        m_startTime = timeNow();
+
+    // due times do not drift when a read is late
+    const double wait = m_startTime + id * m_period - timeNow();
+    if (wait > 0.)
+        std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+
+    frame = Frame(m_images[id % m_images.size()], id, timeNow());
+    return true;
+}
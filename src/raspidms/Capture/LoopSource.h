@@ -0,0 +1,42 @@
+#ifndef LOOPSOURCE_H
+#define LOOPSOURCE_H
+
+#include <vector>
+
+#include "Capture/IFrameSource.h"
+
+/**
+ * @brief The LoopSource class serves frames held in memory, in a loop, at a fixed rate
+ * (or as fast as they are read when fps is 0), e.g. to benchmark the pipeline without a camera.
+ * Images are not copied : every loop serves the same buffers, which must not be drawn on.
+ * Frame ids keep increasing over the loops, and timestamps are the time frames were served.
+ */
+class LoopSource : public IFrameSource
+{
+public:
+    /**
+     * @param images not empty
+     * @param fps
+     * @param maxFrames number of frames served before the end of the source, 0 for no end
+     */
+    LoopSource(const std::vector<cv::Mat>& images, double fps, long maxFrames = 0);
+
+    /**
+     * override bool IFrameSource::isOpened();
+     */
+    virtual bool isOpened() const override;
+
+    /**
+     * override bool IFrameSource::read(Frame&);
+     */
+    virtual bool read(Frame& frame) override;
+
+private:
+    const std::vector<cv::Mat> m_images;
+    const double m_period;
+    const long m_maxFrames;
+    long m_frameId;
+    double m_startTime;
+};
+
+#endif // LOOPSOURCE_H
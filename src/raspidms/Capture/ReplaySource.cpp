@@ -0,0 +1,151 @@
+#include "Capture/ReplaySource.h"
+
+#include "Utils.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+/**
+ * @brief isValidHeader checks that the layout described by header fits in the file,
+ * without overflowing, so that read() never reaches past the mapping
+ * @param header
+ * @param fileSize
+ * @return
+ */
+static bool isValidHeader(const FrameRecordingHeader& header, uint64_t fileSize) {
+    if (std::memcmp(header.magic, FRAME_RECORDING_MAGIC, sizeof(FRAME_RECORDING_MAGIC)) != 0
+            || header.version != FRAME_RECORDING_VERSION)
+        return false;
+
+    // frames are cv::Mat of header.type
+    if (header.width <= 0 || header.height <= 0 || header.elemSize == 0
+            || header.type < 0 || CV_MAT_TYPE(header.type) != header.type
+            || static_cast<uint32_t>(CV_ELEM_SIZE(header.type)) != header.elemSize)
+        return false;
+
+    // the timestamps lie between the header and the first frame
+    const uint64_t timestamps_end = sizeof(FrameRecordingHeader) + static_cast<uint64_t>(header.capacity) * sizeof(double);
+    if (header.numFrames > header.capacity
+            || header.framesOffset < timestamps_end
+            || header.framesOffset > fileSize)
+        return false;
+
+    // frames don't overlap, and the valid ones lie in the file
+    const uint64_t row_size = static_cast<uint64_t>(header.width) * header.elemSize;
+    if (row_size > header.frameStride / static_cast<uint64_t>(header.height)
+            || header.numFrames > (fileSize - header.framesOffset) / header.frameStride)
+        return false;
+
+    return true;
+}
+
+ReplaySource::ReplaySource(const std::string& path, ReplayMode mode, double fps, bool mediaTime)
+    : m_mode(mode),
+      m_period(fps > 0. ? 1. / fps : 0.),
+      m_mediaTime(mediaTime),
+      m_header(nullptr),
+      m_timestamps(nullptr),
+      m_frames(nullptr),
+      m_mappedSize(0),
+      m_nextFrame(0),
+      m_startTime(0.)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "ReplaySource: can't open " << path << std::endl;
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FrameRecordingHeader)) {
+        std::cerr << "ReplaySource: not a recording " << path << std::endl;
+        close(fd);
+        return;
+    }
+
+    // private writable mapping : pages are shared with the page cache until written to
+    void* data = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "ReplaySource: can't map " << path << std::endl;
+        return;
+    }
+
+    const FrameRecordingHeader* header = static_cast<const FrameRecordingHeader*>(data);
+    if (!isValidHeader(*header, st.st_size)) {
+        std::cerr << "ReplaySource: unsupported recording " << path << std::endl;
+        munmap(data, st.st_size);
+        return;
+    }
+
+    m_mappedSize = st.st_size;
+    m_header = header;
+    m_timestamps = reinterpret_cast<const double*>(static_cast<char*>(data) + sizeof(FrameRecordingHeader));
+    m_frames = static_cast<char*>(data) + header->framesOffset;
+
+    // reading ahead helps sequential replay at max speed
+    madvise(data, m_mappedSize, MADV_SEQUENTIAL);
+}
+
+ReplaySource::~ReplaySource() {
+    if (m_header)
+        munmap(const_cast<FrameRecordingHeader*>(m_header), m_mappedSize);
+}
+
+bool ReplaySource::isRecording(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    char magic[sizeof(FRAME_RECORDING_MAGIC)];
+    const bool is_recording = ::read(fd, magic, sizeof(magic)) == sizeof(magic)
+            && std::memcmp(magic, FRAME_RECORDING_MAGIC, sizeof(magic)) == 0;
+    close(fd);
+    return is_recording;
+}
+
+bool ReplaySource::isOpened() const {
+    return m_header != nullptr;
+}
+
+size_t ReplaySource::size() const {
+    return m_header ? m_header->numFrames : 0;
+}
+
+bool ReplaySource::read(Frame& frame) {
+    if (!m_header || m_nextFrame >= m_header->numFrames)
+        return false;
+
+    const size_t index = m_nextFrame++;
+    if (index == 0)
+        m_startTime = timeNow();
+
+    double due_time = m_startTime;
+    switch (m_mode) {
+    case ReplayMode::OriginalTiming:
+        due_time += m_timestamps[index] - m_timestamps[0];
+        break;
+    case ReplayMode::FixedRate:
+        due_time += index * m_period;
+        break;
+    case ReplayMode::MaxSpeed:
+        break;
+    }
+
+    const double wait = due_time - timeNow();
+    if (wait > 0.)
+        std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+
+    cv::Mat image(m_header->height, m_header->width, m_header->type,
+                  m_frames + index * m_header->frameStride,
+                  static_cast<size_t>(m_header->width) * m_header->elemSize);
+    frame = Frame(image, static_cast<long>(index), m_mediaTime ? m_timestamps[index] : timeNow());
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef REPLAYSOURCE_H
+#define REPLAYSOURCE_H
+
+#include <string>
+
+#include "Capture/FrameRecordingFormat.h"
+#include "Capture/IFrameSource.h"
+
+enum class ReplayMode {
+    OriginalTiming,   // frames are served with the delays they were captured with
+    FixedRate,        // frames are served at a given rate
+    MaxSpeed,         // frames are served as soon as they are read
+};
+
+/**
+ * @brief The ReplaySource class serves the frames of a recording made by FrameRecorder
+ * Frames are not copied : their images point into the memory-mapped file (mapped copy-on-write,
+ * so drawing on them is possible, and does not change the file).
+ * Frames must not be used after the ReplaySource is destroyed.
+ * Frame ids are the indices in the recording, and timestamps the time they were served,
+ * so that latencies are measured as with a camera, or the recorded capture timestamps (mediaTime)
+ * for offline processing.
+ */
+class ReplaySource : public IFrameSource
+{
+public:
+    /**
+     * @param path recording path
+     * @param mode
+     * @param fps rate of ReplayMode::FixedRate
+     * @param mediaTime
+     */
+    ReplaySource(const std::string& path, ReplayMode mode, double fps = 30., bool mediaTime = false);
+    ReplaySource(const ReplaySource&) = delete;
+    ~ReplaySource();
+
+    /**
+     * @brief isRecording
+     * @param path
+     * @return true if the file at path is a frame recording
+     */
+    static bool isRecording(const std::string& path);
+
+    /**
+     * override bool IFrameSource::isOpened();
+     */
+    virtual bool isOpened() const override;
+
+    /**
+     * override bool IFrameSource::read(Frame&);
+     */
+    virtual bool read(Frame& frame) override;
+
+    /**
+     * @brief size
+     * @return number of frames in the recording
+     */
+    size_t size() const;
+
+private:
+    const ReplayMode m_mode;
+    const double m_period;
+    const bool m_mediaTime;
+    const FrameRecordingHeader* m_header;
+    const double* m_timestamps;
+    char* m_frames;
+    size_t m_mappedSize;
+    size_t m_nextFrame;
+    double m_startTime;
+};
+
+#endif // REPLAYSOURCE_H
@@ -0,0 +1,33 @@
+#include "Capture/VideoCaptureSource.h"
+
+#include "Utils.h"
+
+#include <algorithm>
+
+VideoCaptureSource::VideoCaptureSource(const std::string& path, bool mediaTime)
+    : m_capture(),
+      m_mediaTime(mediaTime),
+      m_frameId(0)
+{
+    if (!path.empty() && std::all_of(path.begin(), path.end(), ::isdigit)) {
+        m_capture.open(std::stoi(path));
+    } else {
+        m_capture.open(path);
+    }
+}
+
+bool VideoCaptureSource::isOpened() const {
+    return m_capture.isOpened();
+}
+
+bool VideoCaptureSource::read(Frame& frame) {
+    // a new buffer each time
+    cv::Mat image;
+    m_capture.read(image);
+    if (image.empty())
+        return false;
+
+    const double timestamp = m_mediaTime ? m_capture.get(cv::CAP_PROP_POS_MSEC) / 1000. : timeNow();
+    frame = Frame(image, m_frameId++, timestamp);
+    return true;
+}
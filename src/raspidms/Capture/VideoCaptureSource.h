@@ -0,0 +1,40 @@
+#ifndef VIDEOCAPTURESOURCE_H
+#define VIDEOCAPTURESOURCE_H
+
+#include <string>
+
+#include <opencv2/videoio.hpp>
+
+#include "Capture/IFrameSource.h"
+
+/**
+ * @brief The VideoCaptureSource class reads frames from a camera or a video file with cv::VideoCapture
+ * Frames are timestamped with the time they were read, or with their position in the video (mediaTime),
+ * for offline processing faster or slower than real time.
+ */
+class VideoCaptureSource : public IFrameSource
+{
+public:
+    /**
+     * @param path camera index (digits only) or video file path
+     * @param mediaTime
+     */
+    VideoCaptureSource(const std::string& path, bool mediaTime = false);
+
+    /**
+     * override bool IFrameSource::isOpened();
+     */
+    virtual bool isOpened() const override;
+
+    /**
+     * override bool IFrameSource::read(Frame&);
+     */
+    virtual bool read(Frame& frame) override;
+
+private:
+    cv::VideoCapture m_capture;
+    const bool m_mediaTime;
+    long m_frameId;
+};
+
+#endif // VIDEOCAPTURESOURCE_H
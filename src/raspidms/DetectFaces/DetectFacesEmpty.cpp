@@ -7,10 +7,9 @@ DetectFacesEmpty::DetectFacesEmpty(const std::string & path) : IDetectFaces(path
 
 }
 
-PointsList DetectFacesEmpty::operator()(const cv::Mat & frame) {
+void DetectFacesEmpty::operator()(const cv::Mat & frame, FaceResults& faces) {
 
     (void)frame;
-    PointsList faces;
+    (void)faces;
     std::cerr << "Warning: using DetectFacesEmpty" << std::endl;
-    return faces;
 }
@@ -3,11 +3,11 @@
 
 #include "DetectFaces/IDetectFaces.h"
 
-class DetectFacesEmpty : public IDetectFaces
+class DetectFacesEmpty final : public IDetectFaces
 {
 public:
     DetectFacesEmpty(const std::string & path = std::string());
-    virtual PointsList operator()(const cv::Mat & frame) override;
+    virtual void operator()(const cv::Mat & frame, FaceResults& faces) override;
 
 private:
     const long m_id;
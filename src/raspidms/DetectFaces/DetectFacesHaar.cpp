@@ -16,19 +16,19 @@ DetectFacesHaar::DetectFacesHaar(const std::string & path) :
 
 }
 
-PointsList DetectFacesHaar::operator()(const cv::Mat & frame) {
-    std::cout << "haar" << std::endl;
+void DetectFacesHaar::operator()(const cv::Mat & frame, FaceResults& faces) {
+    PhaseTimer timer(m_phaseTimings);
     cv::Mat frameCopy = frame.clone();
     // Convert to gray
     cv::cvtColor(frame, frameCopy, cv::COLOR_BGR2GRAY);
+    timer.mark(PHASE_PREPROCESS);
 
     std::vector<cv::Rect> faces_rect;
     m_faceCascade.detectMultiScale(frameCopy, faces_rect, 1.15, 5);
+    timer.mark(PHASE_INFERENCE);
 
-    PointsList faces;
     for (auto rect : faces_rect) {
-        faces.push_back({rect.tl(), rect.br()});
+        faces.addFace(rect.tl(), rect.br());
     }
-
-    return faces;
+    timer.mark(PHASE_POSTPROCESS);
 }
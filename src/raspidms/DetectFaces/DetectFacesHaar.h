@@ -3,11 +3,11 @@
 
 #include "DetectFaces/IDetectFaces.h"
 
-class DetectFacesHaar : public IDetectFaces
+class DetectFacesHaar final : public IDetectFaces
 {
 public:
     DetectFacesHaar(const std::string & path);
-    virtual PointsList operator()(const cv::Mat & frame) override;
+    virtual void operator()(const cv::Mat & frame, FaceResults& faces) override;
 
 private:
 
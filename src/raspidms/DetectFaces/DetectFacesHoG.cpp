@@ -1,5 +1,6 @@
 #include "DetectFaces/DetectFacesHoG.h"
 
+#include "DlibUtils.h"
 #include "Utils.h"
 
 #include <dlib/opencv/cv_image.h>
@@ -7,26 +8,28 @@
 DetectFacesHoG::DetectFacesHoG(const std::string & path)
     : IDetectFaces(path),
       m_frontalFaceDetector(dlib::get_frontal_face_detector()),
+      m_resizedFrame(),
       m_id(getUniqueId())
 {
 
 }
 
-PointsList DetectFacesHoG::operator()(const cv::Mat & frame) {
-    PointsList faces;
+void DetectFacesHoG::operator()(const cv::Mat & frame, FaceResults& faces) {
+    PhaseTimer timer(m_phaseTimings);
+    if (frame.empty())
+        return;
 
-    cv::Mat frameCopy = frame.clone();
-    cv::resize(frame, frameCopy, cv::Size(224, 224));
+    // resized frame buffer is reused between calls, and wrapped by dlib without copy
+    cv::resize(frame, m_resizedFrame, cv::Size(224, 224));
 
     const float scale_x = 224. / frame.cols;
     const float scale_y = 224. / frame.rows;
-
-    dlib::array2d<dlib::bgr_pixel> dlibFrame;
-    dlib::assign_image(dlibFrame, dlib::cv_image<dlib::bgr_pixel>(frameCopy));
+    timer.mark(PHASE_PREPROCESS);
 
     // Now tell the face detector to give us a list of bounding boxes
     // around all the faces it can find in the image.
-    std::vector<dlib::rectangle> dets = m_frontalFaceDetector(dlibFrame);
+    std::vector<dlib::rectangle> dets = m_frontalFaceDetector(dlib::cv_image<dlib::bgr_pixel>(m_resizedFrame));
+    timer.mark(PHASE_INFERENCE);
 
     //to openCV rect and rescale
     std::for_each(dets.begin(), dets.end(), [&](dlib::rectangle r) {
@@ -35,8 +38,7 @@ PointsList DetectFacesHoG::operator()(const cv::Mat & frame) {
         cvRect.y /= scale_y;
         cvRect.width /= scale_x;
         cvRect.height /= scale_y;
-        faces.push_back({cvRect.tl(), cvRect.br()});
+        faces.addFace(cvRect.tl(), cvRect.br());
     });
-
-    return faces;
+    timer.mark(PHASE_POSTPROCESS);
 }
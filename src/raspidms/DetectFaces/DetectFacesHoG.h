@@ -12,16 +12,17 @@
 #include <opencv2/dnn.hpp>
 #include <opencv2/core/utility.hpp>
 
-class DetectFacesHoG : public IDetectFaces
+class DetectFacesHoG final : public IDetectFaces
 {
 public:
     DetectFacesHoG(const std::string & path = std::string());
-    virtual PointsList operator()(const cv::Mat & frame) override;
+    virtual void operator()(const cv::Mat & frame, FaceResults& faces) override;
 
 private:
 
     //warning maybe not reentrant
     dlib::frontal_face_detector m_frontalFaceDetector;
+    cv::Mat m_resizedFrame;
     const long m_id;
 };
 
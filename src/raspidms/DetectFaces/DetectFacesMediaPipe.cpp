@@ -15,6 +15,7 @@
 #include "tensorflow/lite/optional_debug_tools.h"
 
 
+#include <algorithm>
 #include <chrono>
 #include <map>
 #include <thread>
@@ -66,12 +67,16 @@ static const std::map<std::string, double> kOutputParameters = {
     {"min_score_thresh", 0.5},
 };
 
-static tflite::FlatBufferModel& getModel(const std::string & path) {
-    static std::unique_ptr<tflite::FlatBufferModel> flatBufferModel(nullptr);
-    if (!flatBufferModel)
-        flatBufferModel = tflite::FlatBufferModel::BuildFromFile(path.c_str(), nullptr);
-
-    return *flatBufferModel;
+/**
+ * @brief getModel load the model once, shared by every interpreter (models are preloaded from several threads at once)
+ * @param path
+ * @return the model, null if it could not be loaded
+ */
+static tflite::FlatBufferModel* getModel(const std::string & path) {
+    // static initialization is thread safe : one load, the other threads wait for it
+    static const std::unique_ptr<tflite::FlatBufferModel> flatBufferModel =
+        tflite::FlatBufferModel::BuildFromFile(path.c_str(), nullptr);
+    return flatBufferModel.get();
 }
 
 static tflite::ops::builtin::BuiltinOpResolver& getResolver() {
@@ -83,7 +88,8 @@ DetectFacesMediaPipe::DetectFacesMediaPipe(const std::string & modelPath)
     : IDetectFaces(modelPath),
       m_id(getUniqueId()),
       m_interpreter(nullptr),
-      m_anchors()
+      m_anchors(),
+      m_candidates()
 {
     generate_anchors();
     std::cout << "m_anchors size: " << m_anchors.size() << std::endl;
@@ -93,6 +99,28 @@ DetectFacesMediaPipe::DetectFacesMediaPipe(const std::string & modelPath)
                   << static_cast<int>(kOutputParameters.at("num_boxes")) << std::endl;
         abort();
     }
+
+    // the interpreter is built here rather than on the first frame, for its creation to count as loading
+    tflite::FlatBufferModel* model = getModel(m_path);
+    if (!model) {
+        std::cout << "Error loading model " << m_path << std::endl;
+        return;
+    }
+    auto& resolver = getResolver();
+
+    tflite::InterpreterBuilder builder(*model, resolver);
+    if (builder(&m_interpreter) != kTfLiteOk) {
+        std::cout << "Error building interpreter" << std::endl;
+        m_interpreter.reset();
+        return;
+    } else {
+        printModelIOTensorsInfo();
+    }
+
+    if (m_interpreter->AllocateTensors() != kTfLiteOk) {
+        m_interpreter.reset();
+        std::cout << "Error allocating tensors" << std::endl;
+    }
 }
 
 void DetectFacesMediaPipe::printModelIOTensorsInfo() {
@@ -142,34 +170,18 @@ void DetectFacesMediaPipe::printModelIOTensorsInfo() {
     }
 }
 
-PointsList DetectFacesMediaPipe::operator()(const cv::Mat & frame) {
+void DetectFacesMediaPipe::operator()(const cv::Mat & frame, FaceResults& faces) {
     //std::cout << "Tflite" << std::endl;
-    PointsList faces;
-
     if(frame.empty()) {
         std::cout << "Empty frame !" << std::endl;
-        return faces;
+        return;
     }
 
-    if (!m_interpreter) {
-        auto& model = getModel(m_path);
-        auto& resolver = getResolver();
-
-        tflite::InterpreterBuilder builder(model, resolver);
-        if (builder(&m_interpreter) != kTfLiteOk) {
-            std::cout << "Error building interpreter" << std::endl;
-            m_interpreter.reset();
-            return faces;
-        } else {
-            printModelIOTensorsInfo();
-        }
+    // not loaded (see the constructor)
+    if (!m_interpreter)
+        return;
 
-        if (m_interpreter->AllocateTensors() != kTfLiteOk) {
-            m_interpreter.reset();
-            std::cout << "Error allocating tensors" << std::endl;
-            return faces;
-        }
-    }
+    PhaseTimer timer(m_phaseTimings);
 
     //std::cout << "frame (chan,c,r,t): " << frame.channels() << " " << frame.cols << " " << frame.rows << " " << frame.type() << std::endl;
     cv::Mat frameCopy = frame.clone();
@@ -188,7 +200,9 @@ PointsList DetectFacesMediaPipe::operator()(const cv::Mat & frame) {
     for (size_t i = 0; i < frameCopy.total() * frameCopy.channels(); i++) {
         input_f32[i] = data[i];
     }
+    timer.mark(PHASE_PREPROCESS);
     m_interpreter->Invoke();
+    timer.mark(PHASE_INFERENCE);
 
     //mediapipe face_detection_short_range as two output tensors of dims :
     //[1, 896, 16] for output(0)
@@ -203,7 +217,7 @@ PointsList DetectFacesMediaPipe::operator()(const cv::Mat & frame) {
 
     if (!output_f32_0 || !output_f32_1) {
         std::cout << "Error output tensors" << std::endl;
-        return faces;
+        return;
     }
 
     const float x_scale = kOutputParameters.at("x_scale");
@@ -213,13 +227,15 @@ PointsList DetectFacesMediaPipe::operator()(const cv::Mat & frame) {
 
     const float threshold = kOutputParameters.at("min_score_thresh");
 
-    const int num_kp = kOutputParameters.at("num_keypoints");
+    const int num_kp = std::min(static_cast<int>(kOutputParameters.at("num_keypoints")), MAX_KEYPOINTS);
     const int num_val_per_kp = kOutputParameters.at("num_values_per_keypoint");
 
     const bool reverse_output_order = kOutputParameters.at("reverse_output_order") > 0.f;
 
     const float bounding_box_scale_up = 2.f;
 
+    m_candidates.clear();
+
     for (size_t i = 0; i < static_cast<int>(kOutputParameters.at("num_boxes")); ++i) {
         if (output_f32_1[i] > threshold) {
             int box_offset = static_cast<int>(i * kOutputParameters.at("num_coords") + kOutputParameters.at("box_coord_offset"));
@@ -252,18 +268,18 @@ PointsList DetectFacesMediaPipe::operator()(const cv::Mat & frame) {
             const float height = h * frame.rows;
 
             if (width >= 0 && height >= 0 && left >= 0 && top >= 0) {
-                std::vector<cv::Point2f> points;
+                Candidate candidate;
 
                 //head box
-                points.push_back(cv::Point2f(left, top));
-                points.push_back(cv::Point2f(right, bottom));
+                candidate.box = cv::Rect2f(cv::Point2f(left, top), cv::Point2f(right, bottom));
+                candidate.score = output_f32_1[i];
 
                 //eyes, nose, mouth, ears, points
-                // Keypoints are unused for now
+                // Eyes are used by FaceFeaturesMediaPipe to align the face mesh input
                 int keypoint_index = 0;
                 float keypoint_x = 0.f;
                 float keypoint_y = 0.f;
-                for (int j = 0; j < num_kp * num_val_per_kp ; j+= num_val_per_kp) {
+                for (int j = 0, k = 0; j < num_kp * num_val_per_kp ; j+= num_val_per_kp, ++k) {
                     keypoint_index = box_offset + kOutputParameters.at("keypoint_coord_offset") + j;
                     keypoint_y = output_f32_0[keypoint_index];
                     keypoint_x = output_f32_0[keypoint_index + 1];
@@ -272,32 +288,35 @@ PointsList DetectFacesMediaPipe::operator()(const cv::Mat & frame) {
                         keypoint_y = output_f32_0[keypoint_index + 1];
                     }
 
-                    keypoint_x = keypoint_x / x_scale * w_anchor + m_anchors[i][0] * frame.cols;
-                    keypoint_y = keypoint_y / y_scale * h_anchor + m_anchors[i][1] * frame.rows;
+                    keypoint_x = (keypoint_x / x_scale * w_anchor + m_anchors[i][0]) * frame.cols;
+                    keypoint_y = (keypoint_y / y_scale * h_anchor + m_anchors[i][1]) * frame.rows;
 
-                    points.push_back(cv::Point2f(keypoint_x, keypoint_y));
+                    candidate.keypoints[k] = cv::Point2f(keypoint_x, keypoint_y);
                 }
 
-                faces.push_back(points);
+                m_candidates.push_back(candidate);
             }
         }
     }
 
-    if (faces.empty())
-        return faces;
+    if (m_candidates.empty()) {
+        timer.mark(PHASE_POSTPROCESS);
+        return;
+    }
 
     // Eliminate excessive detections
-    filterSimilarIOU(faces, 0.6);
-
-    //std::cout << __FUNCTION__ << " final_faces.size() = " << final_faces.size() << std::endl;
-    for (auto vec : faces) {
-        std::cout << "head (" << vec[0] << ", " << vec[1] << ")" << std::endl
-                  << "r eye, l eye, nose, mouth, r ear, l ear ("
-                  << vec[2] << ", " << vec[3] << ", " << vec[4] << ", " << vec[5]
-                  << vec[6] << ", " << vec[7] << ")" << std::endl;
-    }
+    filterSimilarIOU(m_candidates, 0.6);
+
+    faces.numKeypoints = num_kp;
+    for (const auto& candidate : m_candidates) {
+        const int face = faces.addFace(candidate.box.tl(), candidate.box.br(), candidate.score);
+        if (face < 0)
+            break;
 
-    return faces;
+        for (int k = 0; k < num_kp; ++k)
+            faces.setKeypoint(face, k, candidate.keypoints[k]);
+    }
+    timer.mark(PHASE_POSTPROCESS);
 }
 
 void DetectFacesMediaPipe::generate_anchors() {
@@ -344,28 +363,28 @@ void DetectFacesMediaPipe::generate_anchors() {
     };
 }
 
-void DetectFacesMediaPipe::filterSimilarIOU(PointsList& faces, float threshold) const {
+void DetectFacesMediaPipe::filterSimilarIOU(std::vector<Candidate>& faces, float threshold) const {
     int first = 0;
     int last = faces.size() - 1;
 
     while (first < last) {
-        auto first_rect = cv::Rect(faces[first][0], faces[first][1]);
-        std::vector<cv::Point2f> max_bd_box = faces[first];
+        auto first_rect = cv::Rect(faces[first].box);
+        Candidate max_bd_box = faces[first];
 
         for (int i = first + 1; i <= last; ++i) {
-            auto candidate_rect = cv::Rect(faces[i][0], faces[i][1]);
+            auto candidate_rect = cv::Rect(faces[i].box);
 
             // If a face overlaps enough with another then they detect the same face
             // Using a while loop because swap of faces[i] and faces[last] may bring a new overlapping face
             while (iou_score(first_rect, candidate_rect) > threshold && i <= last) {
 
                 // save the biggest bounding box
-                if (cv::Rect(max_bd_box[0], max_bd_box[1]).area() < candidate_rect.area())
+                if (cv::Rect(max_bd_box.box).area() < candidate_rect.area())
                     max_bd_box = faces[i];
 
                 // Discard the similar bounding box
                 std::swap(faces[i], faces[last]);
-                candidate_rect = cv::Rect(faces[i][0], faces[i][1]);
+                candidate_rect = cv::Rect(faces[i].box);
                 last--;
             }
         }
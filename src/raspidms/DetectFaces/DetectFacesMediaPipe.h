@@ -8,21 +8,28 @@
 
 #include "tensorflow/lite/interpreter.h"
 
-class DetectFacesMediaPipe : public IDetectFaces
+class DetectFacesMediaPipe final : public IDetectFaces
 {
 public:
     DetectFacesMediaPipe(const std::string & modelPath);
-    virtual PointsList operator()(const cv::Mat & frame) override;
+    virtual void operator()(const cv::Mat & frame, FaceResults& faces) override;
 
     void printModelIOTensorsInfo();
 
 private:
+    struct Candidate {
+        cv::Rect2f box;
+        float score;
+        cv::Point2f keypoints[MAX_KEYPOINTS];
+    };
+
     void generate_anchors();
-    void filterSimilarIOU(PointsList& faces, float threshold) const;
+    void filterSimilarIOU(std::vector<Candidate>& candidates, float threshold) const;
 
     const long m_id;
     std::unique_ptr<tflite::Interpreter> m_interpreter;
     std::vector<std::vector<float>> m_anchors;
+    std::vector<Candidate> m_candidates; // reused between calls
 };
 
 #endif // DETECTFACESMEDIAPIPE_H
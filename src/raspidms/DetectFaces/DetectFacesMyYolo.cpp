@@ -17,14 +17,13 @@ DetectFacesMyYolo::DetectFacesMyYolo(const std::string & path) :
 
 }
 
-PointsList DetectFacesMyYolo::operator()(const cv::Mat & frame) {
-    std::cout << "yolo" << std::endl;
+void DetectFacesMyYolo::operator()(const cv::Mat & frame, FaceResults& faces) {
+    PhaseTimer timer(m_phaseTimings);
     float confThreshold = 0.5;
     float classThreshold = 0.5;
-    PointsList faces;
 
     if(frame.empty())
-        return faces;
+        return;
 
     cv::Mat frameCopy = frame.clone();
     cv::resize(frame, frameCopy, cv::Size(224, 224));
@@ -43,7 +42,9 @@ PointsList DetectFacesMyYolo::operator()(const cv::Mat & frame) {
     cv::divide(blob, std_dev, blob);
 
     m_net.setInput(blob);
+    timer.mark(PHASE_PREPROCESS);
     cv::Mat outs = m_net.forward();
+    timer.mark(PHASE_INFERENCE);
 
     // Network produces output blob with a shape 1x49x(1+4*5)
     // 49 Cells, and per cell : 1 class, 4 boxes, 1 confidence + 4 coords (x,y,w,h) per box.
@@ -106,7 +107,6 @@ PointsList DetectFacesMyYolo::operator()(const cv::Mat & frame) {
               << height << ")"
               << std::endl;*/
 
-    faces.push_back({cv::Point2f(left / scale_x, top / scale_y), cv::Point2f(right / scale_x, bottom / scale_y)});
-
-    return faces;
+    faces.addFace(cv::Point2f(left / scale_x, top / scale_y), cv::Point2f(right / scale_x, bottom / scale_y), class_max * max_conf);
+    timer.mark(PHASE_POSTPROCESS);
 }
@@ -3,11 +3,11 @@
 
 #include "DetectFaces/IDetectFaces.h"
 
-class DetectFacesMyYolo : public IDetectFaces
+class DetectFacesMyYolo final : public IDetectFaces
 {
 public:
     DetectFacesMyYolo(const std::string & path);
-    virtual PointsList operator()(const cv::Mat & frame) override;
+    virtual void operator()(const cv::Mat & frame, FaceResults& faces) override;
 
 private:
     //warning dnn::Net seems not reentrant
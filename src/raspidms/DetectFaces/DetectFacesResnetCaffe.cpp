@@ -16,13 +16,13 @@ DetectFacesResnetCaffe::DetectFacesResnetCaffe(const std::string & protoTxtPath,
 
 }
 
-PointsList DetectFacesResnetCaffe::operator()(const cv::Mat & frame) {
+void DetectFacesResnetCaffe::operator()(const cv::Mat & frame, FaceResults& faces) {
     // std::cout << "resnetCaffe" << std::endl;
     double confThreshold = 0.5;
-    PointsList faces;
 
+    PhaseTimer timer(m_phaseTimings);
     if(frame.empty())
-        return faces;
+        return;
 
     cv::Mat frameCopy = frame.clone();
     cv::resize(frame, frameCopy, cv::Size(300, 300));
@@ -30,7 +30,9 @@ PointsList DetectFacesResnetCaffe::operator()(const cv::Mat & frame) {
     cv::Mat blob;
     cv::dnn::blobFromImage(frameCopy, blob, 1.0, cv::Size(300, 300));
     m_net.setInput(blob);
+    timer.mark(PHASE_PREPROCESS);
     cv::Mat outs = m_net.forward();
+    timer.mark(PHASE_INFERENCE);
 
     // Network produces output blob with a shape 1x1xNx7 where N is a number of
     // detections and an every detection is a vector of values
@@ -54,11 +56,10 @@ PointsList DetectFacesResnetCaffe::operator()(const cv::Mat & frame) {
                 right  = (float)(data[i + 5] * frame.cols);
                 bottom = (float)(data[i + 6] * frame.rows);
             }
-            faces.push_back({cv::Point2f(left, top), cv::Point2f(right, bottom)});
+            faces.addFace(cv::Point2f(left, top), cv::Point2f(right, bottom), confidence);
         }
     }
+    timer.mark(PHASE_POSTPROCESS);
 
-    // std::cout << __FUNCTION__ << " ---------------> faces.size() = " << faces.size() << std::endl;
-
-    return faces;
+    // std::cout << __FUNCTION__ << " ---------------> faces.numFaces = " << faces.numFaces << std::endl;
 }
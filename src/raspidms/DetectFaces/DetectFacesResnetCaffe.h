@@ -3,11 +3,11 @@
 
 #include "DetectFaces/IDetectFaces.h"
 
-class DetectFacesResnetCaffe : public IDetectFaces
+class DetectFacesResnetCaffe final : public IDetectFaces
 {
 public:
     DetectFacesResnetCaffe(const std::string & protoTxtPath, const std::string & caffeModelPath);
-    virtual PointsList operator()(const cv::Mat & frame) override;
+    virtual void operator()(const cv::Mat & frame, FaceResults& faces) override;
 
 private:
 
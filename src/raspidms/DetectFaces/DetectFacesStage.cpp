@@ -1,12 +1,17 @@
 #include "DetectFaces/DetectFacesStage.h"
 
+// every face detector, or the only one compiled in (BuildConfig.h)
+#ifdef RASPIDMS_ALL_FACE_DETECTORS
 #include "DetectFaces/DetectFacesEmpty.h"
 #include "DetectFaces/DetectFacesHaar.h"
 #include "DetectFaces/DetectFacesMyYolo.h"
 #include "DetectFaces/DetectFacesResnetCaffe.h"
 #include "DetectFaces/DetectFacesHoG.h"
 #include "DetectFaces/DetectFacesMediaPipe.h"
+#endif
 
+#include "Stats/AllocTracker.h"
+#include "Tracing/Tracer.h"
 #include "Utils.h"
 
 const size_t MAX_OUT_QUEUE_SIZE = 4;
@@ -14,101 +19,187 @@ const double INITIAL_AVERAGE_TIME = 0.5;
 const double AVERAGE_ALPHA = 0.1;
 
 DetectFacesStage::DetectFacesStage(const std::string& detectorName,
-                                   std::shared_ptr<SharedQueue<cv::Mat>> inFrames,
-                                   std::shared_ptr<SharedQueue<PointsList>> outRects)
+                                   std::shared_ptr<SharedQueue<Frame>> inFrames,
+                                   std::shared_ptr<SharedQueue<FaceResultsPtr>> outRects)
     : m_detectorName(detectorName),
       m_inFrames(inFrames),
       m_outRects(outRects),
-      m_detectors(),
+      m_resultsPool(),
+      m_detectors("DetectFacesStage", resolveFactory(detectorName)),
       m_mutex(),
       m_averageTime(INITIAL_AVERAGE_TIME),
-      m_averageAlpha(AVERAGE_ALPHA)
+      m_averageAlpha(AVERAGE_ALPHA),
+      m_newestFrameId(-1),
+      m_detectedFrames(0),
+      m_inputScale(1.f),
+      m_detectionInterval(1),
+      m_lastDetection()
 {
 
 }
 
 void DetectFacesStage::operator()(int threadId) {
-    std::cout << "----> DetectFacesStage thread id " << threadId << std::endl;
-    std::shared_ptr<IDetectFaces> detector = getNextDetector(threadId);
-
-    cv::Mat frame;
-    // try pop without emptying
-    if (m_inFrames->size() > 1) {
-        m_inFrames->pop_front_wait(frame);
-    } else {
-        frame = m_inFrames->front_wait();
+    AllocScope alloc_scope(ALLOC_DETECT_FACES);
+    Frame frame;
+    {
+        TRACE_SPAN("detect_faces.wait");
+        // try pop without emptying
+        if (m_inFrames->size() > 1) {
+            m_inFrames->pop_front_wait(frame);
+        } else {
+            frame = m_inFrames->front_wait();
+        }
     }
 
-    if (frame.empty()) {
+    if (frame.image.empty()) {
         std::cout << "DetectFacesStage: " << "empty frame" << std::endl;
         return;
     }
 
-    timeMark(threadId);
+    m_outRects->push_back(process(frame, threadId));
+
+    if (m_outRects->size() > MAX_OUT_QUEUE_SIZE)
+        m_outRects->pop_front_no_wait();
+}
+
+FaceResultsPtr DetectFacesStage::process(const Frame& frame, int threadId) {
+    TRACE_SPAN("detect_faces");
+    AllocScope alloc_scope(ALLOC_DETECT_FACES);
+    FaceResultsPtr faces = m_resultsPool.acquire();
+
+    // between two detections, the boxes of the last one go with the new frame
+    const int interval = m_detectionInterval.load(std::memory_order_relaxed);
+    std::shared_ptr<const FaceResults> last_detection;
+    if (interval > 1) {
+        last_detection = std::atomic_load(&m_lastDetection);
+        if (last_detection && frame.id > last_detection->frame.id
+                && frame.id - last_detection->frame.id < interval) {
+            faces->copyFacesFrom(*last_detection);
+            faces->frame = frame;
+            countDetectedFrame(frame.id);
+            return faces;
+        }
+    }
+
+    FaceDetectorType* const detector = m_detectors.get(threadId);
+
+    faces->clear();
+    faces->frame = frame;
+    faces->detectionTimestamp = frame.timestamp;
+
+    const double start = timeNow();
     // Detect the faces
-    PointsList pl = (*detector)(frame);
+    const float scale = m_inputScale.load(std::memory_order_relaxed);
+    if (scale < 1.f) {
+        // resized frame buffer of this thread, reused between calls
+        thread_local cv::Mat resized_frame;
+        cv::resize(frame.image, resized_frame, cv::Size(), scale, scale, cv::INTER_AREA);
+        if (detector)
+            (*detector)(resized_frame, *faces);
+        faces->scaleFaces(1.f / scale);
+    } else if (detector) {
+        (*detector)(frame.image, *faces);
+    }
+
+    const double duration = timeNow() - start;
+    faces->setStageTiming(STAGE_DETECT_FACES, duration, threadId);
 
     // Exponential moving average
-    m_averageTime = m_averageAlpha * timeMark(threadId) + (1. - m_averageAlpha) * m_averageTime;
+    m_averageTime = m_averageAlpha * duration + (1. - m_averageAlpha) * m_averageTime;
 
-    std::cout << "DetectFacesStage average time: " << m_averageTime << std::endl;
+    if (interval > 1 && (!last_detection || frame.id > last_detection->frame.id))
+        std::atomic_store(&m_lastDetection, std::shared_ptr<const FaceResults>(faces));
 
-    m_outRects->push_back(pl);
+    countDetectedFrame(frame.id);
 
-    if (m_outRects->size() > MAX_OUT_QUEUE_SIZE)
-        m_outRects->pop_front_no_wait();
+    return faces;
 }
 
-std::shared_ptr<IDetectFaces> DetectFacesStage::getNextDetector(int threadId) {
+void DetectFacesStage::countDetectedFrame(long frameId) {
+    // frames are detected again while no newer one comes in
+    long newest = m_newestFrameId.load(std::memory_order_relaxed);
+    while (frameId > newest && !m_newestFrameId.compare_exchange_weak(newest, frameId, std::memory_order_relaxed)) {}
+    if (frameId > newest)
+        m_detectedFrames.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DetectFacesStage::setDetector(const std::string& detectorName) {
     std::lock_guard<std::mutex> guard(m_mutex);
+    if (detectorName == m_detectorName)
+        return;
 
-    auto detectorIt = m_detectors.find(threadId);
-    if (detectorIt != m_detectors.end()) {
-        return detectorIt->second;
-    } else {
-        std::shared_ptr<IDetectFaces> detector;
-        if (m_detectorName == "haar")
-        {
-            detector.reset(new DetectFacesHaar(HAAR_CASCADE_PATH));
-            m_detectors.insert({threadId , detector});
-        }
-        else if (m_detectorName == "resnetCaffe")
-        {
-            detector.reset(new DetectFacesResnetCaffe(RESNET_CAFFE_PROTO_TXT_PATH, RESNET_CAFFE_MODEL_PATH));
-            m_detectors.insert({threadId, detector});
-        }
-        else if (m_detectorName == "yoloResnet18")
-        {
-            detector.reset(new DetectFacesMyYolo(MY_YOLO_RESNET_18_PATH));
-            m_detectors.insert({threadId, detector});
-        }
-        else if (m_detectorName == "yoloEffnetb0")
-        {
-            detector.reset(new DetectFacesMyYolo(MY_YOLO_EFFNET_B0_PATH));
-            m_detectors.insert({threadId, detector});
-        }
-        else if (m_detectorName == "hog")
-        {
-            detector.reset(new DetectFacesHoG());
-            m_detectors.insert({threadId, detector});
-        }
-        else if (m_detectorName == "mediapipe")
-        {
-            detector.reset(new DetectFacesMediaPipe(MEDIAPIPE_FD_MODEL_PATH));
-            m_detectors.insert({threadId, detector});
-        }
-        else if (m_detectorName == "empty")
-        {
-            detector.reset(new DetectFacesEmpty());
-            m_detectors.insert({threadId, detector});
-        }
-        else //do not insert detector if name unkown, but still return empty one
-        {
-            detector.reset(new DetectFacesEmpty());
+    // each thread replaces its detector on its next frame
+    m_detectorName = detectorName;
+    m_detectors.setFactory(resolveFactory(detectorName));
+}
+
+DetectFacesFactory DetectFacesStage::resolveFactory(const std::string& detectorName) {
+    const DetectFacesFactory factory = detectorFactory(detectorName);
+#ifdef RASPIDMS_ALL_FACE_DETECTORS
+    if (!factory)
+        return []() -> FaceDetectorType* { return new DetectFacesEmpty(); };
+#else
+    if (!factory)
+        std::cerr << "DetectFacesStage: face detector " << detectorName << " not compiled in" << std::endl;
+#endif
+    return factory;
+}
+
+DetectFacesFactory DetectFacesStage::detectorFactory(const std::string& detectorName) {
+#if defined(RASPIDMS_ALL_FACE_DETECTORS) || defined(RASPIDMS_FACE_DETECTOR_HAAR)
+    if (detectorName == "haar")
+        return []() -> FaceDetectorType* { return new DetectFacesHaar(HAAR_CASCADE_PATH); };
+#endif
+#if defined(RASPIDMS_ALL_FACE_DETECTORS) || defined(RASPIDMS_FACE_DETECTOR_RESNETCAFFE)
+    if (detectorName == "resnetCaffe")
+        return []() -> FaceDetectorType* { return new DetectFacesResnetCaffe(RESNET_CAFFE_PROTO_TXT_PATH, RESNET_CAFFE_MODEL_PATH); };
+#endif
+#if defined(RASPIDMS_ALL_FACE_DETECTORS) || defined(RASPIDMS_FACE_DETECTOR_YOLORESNET18)
+    if (detectorName == "yoloResnet18")
+        return []() -> FaceDetectorType* { return new DetectFacesMyYolo(MY_YOLO_RESNET_18_PATH); };
+#endif
+#if defined(RASPIDMS_ALL_FACE_DETECTORS) || defined(RASPIDMS_FACE_DETECTOR_YOLOEFFNETB0)
+    if (detectorName == "yoloEffnetb0")
+        return []() -> FaceDetectorType* { return new DetectFacesMyYolo(MY_YOLO_EFFNET_B0_PATH); };
+#endif
+#if defined(RASPIDMS_ALL_FACE_DETECTORS) || defined(RASPIDMS_FACE_DETECTOR_HOG)
+    if (detectorName == "hog")
+        return []() -> FaceDetectorType* { return new DetectFacesHoG(); };
+#endif
+#if defined(RASPIDMS_ALL_FACE_DETECTORS) || defined(RASPIDMS_FACE_DETECTOR_MEDIAPIPE)
+    if (detectorName == "mediapipe")
+        return []() -> FaceDetectorType* { return new DetectFacesMediaPipe(MEDIAPIPE_FD_MODEL_PATH); };
+#endif
+#ifdef RASPIDMS_ALL_FACE_DETECTORS
+    if (detectorName == "empty")
+        return []() -> FaceDetectorType* { return new DetectFacesEmpty(); };
+#endif
+
+    return nullptr;
+}
+
+std::shared_ptr<IDetectFaces> DetectFacesStage::createDetector(const std::string& detectorName) {
+    const DetectFacesFactory factory = detectorFactory(detectorName);
+    return std::shared_ptr<IDetectFaces>(factory ? factory() : nullptr);
+}
+
+ModelStartupTimes DetectFacesStage::preloadDetector(int threadId, const cv::Mat& warmupFrame, int warmupRuns) {
+    return m_detectors.preload(threadId, [&](FaceDetectorType& detector) {
+        std::unique_ptr<FaceResults> faces(new FaceResults());
+        for (int run = 0; run < warmupRuns; ++run) {
+            faces->clear();
+            detector(warmupFrame, *faces);
         }
+    });
+}
 
-        return detector;
-    }
+std::string DetectFacesStage::detectorName() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_detectorName;
+}
+
+void DetectFacesStage::releaseDetector(int threadId) {
+    m_detectors.release(threadId);
 }
 
 double DetectFacesStage::averageTime() {
@@ -1,7 +1,8 @@
 #ifndef DETECTFACESSTAGE_H
 #define DETECTFACESSTAGE_H
 
-#include <unordered_map>
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <utility>
@@ -14,9 +15,13 @@
 #include <opencv2/dnn.hpp>
 #include <opencv2/core/utility.hpp>
 
+#include "BuildConfig.h"
 #include "DetectFaces/IDetectFaces.h"
+#include "DetectorSlots.h"
 #include "FaceFeatures/IFaceFeatures.h"
+#include "Frame.h"
 #include "IStage.h"
+#include "SharedPool.h"
 #include "SharedQueue.h"
 
 const std::string HAAR_CASCADE_PATH = "haarcascades/haarcascade_frontalface_default.xml";
@@ -26,13 +31,25 @@ const std::string MY_YOLO_RESNET_18_PATH = "../res/YoloResnet18.onnx";
 const std::string MY_YOLO_EFFNET_B0_PATH = "../res/YoloEffnetb0.onnx";
 const std::string MEDIAPIPE_FD_MODEL_PATH = "../res/face_detection_short_range.tflite";
 
+/**
+ * @brief DetectFacesFactory creates a face detector, resolved from its name once (see DetectFacesStage::detectorFactory)
+ */
+typedef DetectorSlots<FaceDetectorType>::Factory DetectFacesFactory;
+
+/**
+ * @brief The DetectFacesStage class detects faces in the input frames
+ *
+ * Each thread id gets its own detector (see DetectorSlots) : finding it takes no lock.
+ * The factory is resolved from the detector name at construction, and when the detector is switched (setDetector).
+ * In a single configuration build (see BuildConfig.h), only the face detector compiled in is known.
+ */
 class DetectFacesStage : public IStage
 {
 
 public:
     DetectFacesStage(const std::string& detectorName,
-                     std::shared_ptr<SharedQueue<cv::Mat>> inFrames,
-                     std::shared_ptr<SharedQueue<PointsList>> outRects);
+                     std::shared_ptr<SharedQueue<Frame>> inFrames,
+                     std::shared_ptr<SharedQueue<FaceResultsPtr>> outRects);
     DetectFacesStage(const DetectFacesStage&) = delete;
 
     /**
@@ -45,21 +62,103 @@ public:
      */
     virtual double averageTime() override;
 
-private:
     /**
-     * @brief getNextDetector
+     * @brief process detect the faces of frame, without going through the queues
+     * @param frame
+     * @param threadId
+     * @return the faces found (possibly none)
+     */
+    FaceResultsPtr process(const Frame& frame, int threadId);
+
+    /**
+     * @brief createDetector
+     * @param detectorName haar, resnetCaffe, yoloResnet18, yoloEffnetb0, hog, mediapipe or empty
+     * @return a new detector, null if detectorName is unknown (or not compiled in)
+     */
+    static std::shared_ptr<IDetectFaces> createDetector(const std::string& detectorName);
+
+    /**
+     * @brief detectorFactory
+     * @param detectorName see createDetector
+     * @return the factory of the detector, null if detectorName is unknown (or not compiled in)
+     */
+    static DetectFacesFactory detectorFactory(const std::string& detectorName);
+
+    /**
+     * @brief detectedFrames
+     * @return number of frames detected so far, each counted once however many times it was detected
+     * (only frames newer than all the previous ones are counted)
+     */
+    long detectedFrames() const { return m_detectedFrames.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief setDetector switch to another detector, each thread creates its own on its next frame
+     * (an unknown name gives an empty detector, or none in a single configuration build)
+     * @param detectorName see createDetector
+     */
+    void setDetector(const std::string& detectorName);
+
+    /**
+     * @brief setInputScale detect faces on frames resized by scale (boxes are scaled back to the frame)
+     * @param scale in ]0, 1], 1 to detect on the frames as they are
+     */
+    void setInputScale(float scale) { m_inputScale.store(scale, std::memory_order_relaxed); }
+
+    /**
+     * @brief setDetectionInterval detect faces on one frame out of interval (by frame id),
+     * the frames in between get the boxes of the last detection
+     * @param interval >= 1
+     */
+    void setDetectionInterval(int interval) { m_detectionInterval.store(interval, std::memory_order_relaxed); }
+
+    /**
+     * @brief preloadDetector create the detector of a thread ahead of its first frame, and warm it up
+     * (nothing is done if the thread already has one, or if the detector is not compiled in)
+     * To be called before the thread with threadId runs the stage.
+     * @param threadId
+     * @param warmupFrame
+     * @param warmupRuns
+     * @return the time it took to create the detector, and to run it warmupRuns times on warmupFrame
+     */
+    ModelStartupTimes preloadDetector(int threadId, const cv::Mat& warmupFrame, int warmupRuns);
+
+    /**
+     * @brief detectorName
+     * @return name of the current detector
+     */
+    std::string detectorName();
+
+    /**
+     * @brief releaseDetector free the detector of a thread that will not run this stage anymore
+     * (a thread id given again gets a new detector)
+     * To be called from the thread with threadId, or while no thread runs the stage with threadId.
      * @param threadId
-     * @return next detector, scheduled by schedNextDetector, and specialized by threadId (one threadId for one detector)
      */
-    std::shared_ptr<IDetectFaces> getNextDetector(int threadId);
+    void releaseDetector(int threadId);
+
+private:
+    /**
+     * @brief resolveFactory
+     * @param detectorName
+     * @return the factory of detectorName, or of the empty detector if unknown (none in a single configuration build)
+     */
+    static DetectFacesFactory resolveFactory(const std::string& detectorName);
+
+    void countDetectedFrame(long frameId);
 
-    const std::string m_detectorName;
-    std::shared_ptr<SharedQueue<cv::Mat>> m_inFrames;
-    std::shared_ptr<SharedQueue<PointsList>> m_outRects;
-    std::unordered_map<int /*threadId*/, std::shared_ptr<IDetectFaces>> m_detectors;
-    std::mutex m_mutex;
+    std::string m_detectorName;
+    std::shared_ptr<SharedQueue<Frame>> m_inFrames;
+    std::shared_ptr<SharedQueue<FaceResultsPtr>> m_outRects;
+    SharedPool<FaceResults> m_resultsPool;
+    DetectorSlots<FaceDetectorType> m_detectors;
+    std::mutex m_mutex;                             // guards m_detectorName
     double m_averageTime;
     double m_averageAlpha;
+    std::atomic<long> m_newestFrameId;
+    std::atomic<long> m_detectedFrames;
+    std::atomic<float> m_inputScale;
+    std::atomic<int> m_detectionInterval;
+    std::shared_ptr<const FaceResults> m_lastDetection;   // only with a detection interval, atomic_load / atomic_store
 };
 
 #endif // DETECTFACESSTAGE_H
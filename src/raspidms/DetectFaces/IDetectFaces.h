@@ -2,6 +2,7 @@
 #define IDETECTFACES_H
 
 #include "IStage.h"
+#include "PhaseTimings.h"
 
 #include <opencv2/core.hpp>
 #include <opencv2/objdetect.hpp>
@@ -19,21 +20,26 @@ class IDetectFaces
 public:
     IDetectFaces(const std::string & path,
                  const std::string & secondPath = std::string())
-        : m_path(path), m_secondPath(secondPath) {}
+        : m_path(path), m_secondPath(secondPath), m_phaseTimings() {}
     virtual ~IDetectFaces() {}
 
     /**
      * @brief operator ()
      * @param frame
-     * @return pair of
-     * - a vector of rectangles of faces (upleft, upright, w, h)
-     * - a double : time in second it took for computing
+     * @param faces cleared FaceResults, to be filled with bounding boxes, scores and keypoints if any
      */
-    virtual PointsList operator()(const cv::Mat& frame) = 0;
+    virtual void operator()(const cv::Mat& frame, FaceResults& faces) = 0;
+
+    /**
+     * @brief phaseTimings
+     * @return preprocessing, inference and postprocessing times of the last call
+     */
+    const PhaseTimings& phaseTimings() const { return m_phaseTimings; }
 
 protected:
     const std::string m_path;
     const std::string m_secondPath;
+    PhaseTimings m_phaseTimings;
 };
 
 #endif // IDETECTFACES_H
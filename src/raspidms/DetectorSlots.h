@@ -0,0 +1,124 @@
+#ifndef DETECTORSLOTS_H
+#define DETECTORSLOTS_H
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+#include "IStage.h"
+#include "PhaseTimings.h"
+#include "Utils.h"
+
+/**
+ * @brief The DetectorSlots class keeps one detector per thread id (below MAX_STAGE_THREADS), in a preallocated array
+ *
+ * A slot is only used by the thread with its id (a thread id is never run by two threads at once),
+ * so that get() takes no lock : an array index, and an atomic load to see whether the factory was switched.
+ * Detectors are created by a factory resolved once from a name (never on a frame) : on the first get()
+ * of a thread, on its first get() after setFactory(), or ahead by preload().
+ *
+ * Detector is the type the stage calls : the interface (IDetectFaces, IFaceFeatures),
+ * or a final implementation in a single configuration build (see BuildConfig.h), called without virtual dispatch.
+ *
+ * USAGE :
+ * DetectorSlots<IDetectFaces> detectors("DetectFacesStage", []() -> IDetectFaces* { return new DetectFacesHoG(); });
+ * IDetectFaces* detector = detectors.get(threadId);
+ */
+template <typename Detector>
+class DetectorSlots
+{
+public:
+    typedef Detector* (*Factory)();
+
+    /**
+     * @param owner name of the stage, for errors
+     * @param factory null for no detector
+     */
+    DetectorSlots(const char* owner, Factory factory)
+        : m_owner(owner), m_slots(new Slot[MAX_STAGE_THREADS]()), m_factory(factory), m_generation(0) {}
+    DetectorSlots(const DetectorSlots&) = delete;
+
+    /**
+     * @brief get to be called from the thread with threadId
+     * @param threadId
+     * @return the detector of threadId, created if it has none yet, or if the factory was switched since,
+     * null if there is no factory
+     */
+    Detector* get(int threadId) {
+        Slot& detector_slot = slot(threadId);
+        const unsigned generation = m_generation.load(std::memory_order_acquire);
+        if (!detector_slot.detector || detector_slot.generation != generation) {
+            const Factory factory = m_factory.load(std::memory_order_acquire);
+            detector_slot.detector.reset(factory ? factory() : nullptr);
+            detector_slot.generation = generation;
+        }
+        return detector_slot.detector.get();
+    }
+
+    /**
+     * @brief setFactory every thread replaces its detector on its next get()
+     * @param factory
+     */
+    void setFactory(Factory factory) {
+        m_factory.store(factory, std::memory_order_release);
+        m_generation.fetch_add(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief preload create the detector of threadId if it has none, before the thread with threadId runs
+     * @param threadId
+     * @param warmup called on the new detector, before it goes to its slot
+     * @return the time it took to create the detector, and to warm it up (zeros if nothing was done)
+     */
+    template <typename Warmup>
+    ModelStartupTimes preload(int threadId, Warmup warmup) {
+        ModelStartupTimes times = {0., 0.};
+        Slot& detector_slot = slot(threadId);
+        const unsigned generation = m_generation.load(std::memory_order_acquire);
+        const Factory factory = m_factory.load(std::memory_order_acquire);
+        if (detector_slot.detector || !factory)
+            return times;
+
+        double start = timeNow();
+        std::unique_ptr<Detector> detector(factory());
+        times.load = timeNow() - start;
+
+        start = timeNow();
+        warmup(*detector);
+        times.warmup = timeNow() - start;
+
+        detector_slot.detector = std::move(detector);
+        detector_slot.generation = generation;
+        return times;
+    }
+
+    /**
+     * @brief release free the detector of threadId, from the thread with threadId, or while it does not run
+     * @param threadId
+     */
+    void release(int threadId) {
+        slot(threadId).detector.reset();
+    }
+
+private:
+    struct Slot {
+        std::unique_ptr<Detector> detector;
+        unsigned generation;    // of the factory the detector was created by
+    };
+
+    Slot& slot(int threadId) {
+        if (threadId < 0 || threadId >= MAX_STAGE_THREADS) {
+            std::cerr << m_owner << ": thread id " << threadId << " out of [0, " << MAX_STAGE_THREADS << "[" << std::endl;
+            abort();
+        }
+        return m_slots[threadId];
+    }
+
+    const char* const m_owner;
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<Factory> m_factory;
+    std::atomic<unsigned> m_generation;    // incremented after each switch of m_factory
+};
+
+#endif // DETECTORSLOTS_H
@@ -0,0 +1,172 @@
+#include "Display/Display.h"
+
+#include <opencv2/highgui.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "Tracing/Tracer.h"
+#include "Utils.h"
+
+// landmarks are drawn as squares of LANDMARK_SIZE x LANDMARK_SIZE preview pixels
+const int LANDMARK_SIZE = 2;
+
+const cv::Vec3b LANDMARK_COLOR(0, 0, 255);
+
+Display::Display(const std::string& windowName, double previewScale, double maxFps)
+    : m_windowName(windowName),
+      m_previewScale(std::min(1., std::max(0.05, previewScale))),
+      m_minPeriod(maxFps > 0. ? 1. / maxFps : 0.),
+      m_frame(),
+      m_rects(),
+      m_faceFeatures(),
+      m_hasNew(false),
+      m_stop(false),
+      m_mutex(),
+      m_condition(),
+      m_preview(),
+      m_quitRequested(false),
+      m_thread()
+{
+    m_thread = std::thread(&Display::run, this);
+}
+
+Display::~Display() {
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_one();
+    m_thread.join();
+}
+
+void Display::show(const Frame& frame,
+                   std::shared_ptr<const FaceResults> rects,
+                   std::shared_ptr<const FaceResults> faceFeatures) {
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_frame = frame;
+        m_rects = std::move(rects);
+        m_faceFeatures = std::move(faceFeatures);
+        m_hasNew = true;
+    }
+    m_condition.notify_one();
+}
+
+void Display::run() {
+    Tracer::instance().setThreadName("display");
+    cv::namedWindow(m_windowName, cv::WINDOW_AUTOSIZE);
+
+    // no more than one render per m_minPeriod
+    double next_render = 0.;
+
+    Frame frame;
+    std::shared_ptr<const FaceResults> rects;
+    std::shared_ptr<const FaceResults> face_features;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            // wake up regularly anyway, for the window to stay responsive
+            m_condition.wait_for(lock, std::chrono::milliseconds(30), [this] { return m_hasNew || m_stop; });
+            if (m_stop)
+                break;
+
+            const double wait = next_render - timeNow();
+            if (m_hasNew && wait <= 0.) {
+                frame = m_frame;
+                rects = m_rects;
+                face_features = m_faceFeatures;
+                m_hasNew = false;
+
+                // do not hold on to the frame and results longer than needed
+                m_frame = Frame();
+                m_rects.reset();
+                m_faceFeatures.reset();
+            } else if (m_hasNew) {
+                // too early : the latest frame given meanwhile will be shown
+                lock.unlock();
+                std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+                continue;
+            }
+        }
+
+        if (!frame.image.empty()) {
+            TRACE_SPAN("display");
+            next_render = timeNow() + m_minPeriod;
+            render(frame, rects.get(), face_features.get());
+            frame = Frame();
+            rects.reset();
+            face_features.reset();
+            cv::imshow(m_windowName, m_preview);
+        }
+
+        if (cv::pollKey() >= 0)
+            m_quitRequested.store(true, std::memory_order_relaxed);
+    }
+
+    cv::destroyWindow(m_windowName);
+}
+
+void Display::render(const Frame& frame, const FaceResults* rects, const FaceResults* faceFeatures) {
+    const float scale = static_cast<float>(m_previewScale);
+    if (m_previewScale < 1.)
+        cv::resize(frame.image, m_preview, cv::Size(), m_previewScale, m_previewScale, cv::INTER_NEAREST);
+    else
+        frame.image.copyTo(m_preview);
+
+    if (rects) {
+        for (int face = 0; face < rects->numFaces; ++face) {
+            cv::rectangle(m_preview, rects->topLeft(face) * scale, rects->bottomRight(face) * scale,
+                          cv::Scalar(255, 0, 0), 2, cv::LINE_8);
+        }
+    }
+
+    if (!faceFeatures)
+        return;
+
+    // landmarks are written directly to the pixels, rather than one cv::circle per point
+    const int max_x = m_preview.cols - LANDMARK_SIZE;
+    const int max_y = m_preview.rows - LANDMARK_SIZE;
+    for (int face = 0; face < faceFeatures->numFaces; ++face) {
+        if (!faceFeatures->hasLandmarks[face])
+            continue;
+
+        const float* xs = faceFeatures->landmarksX[face];
+        const float* ys = faceFeatures->landmarksY[face];
+        for (int i = 0; i < faceFeatures->numLandmarks; ++i) {
+            const int x = static_cast<int>(xs[i] * scale);
+            const int y = static_cast<int>(ys[i] * scale);
+            if (x < 0 || y < 0 || x > max_x || y > max_y)
+                continue;
+            for (int dy = 0; dy < LANDMARK_SIZE; ++dy) {
+                cv::Vec3b* row = m_preview.ptr<cv::Vec3b>(y + dy) + x;
+                for (int dx = 0; dx < LANDMARK_SIZE; ++dx)
+                    row[dx] = LANDMARK_COLOR;
+            }
+        }
+
+        if (faceFeatures->hasPupils[face]) {
+            for (int eye = 0; eye < 2; ++eye)
+                cv::circle(m_preview, faceFeatures->pupil(face, eye) * scale, 2, cv::Scalar(0, 255, 255), cv::FILLED, cv::LINE_8);
+        }
+    }
+
+    const DriverState& state = faceFeatures->driverState;
+    if (state.valid) {
+        char text[128];
+        snprintf(text, sizeof(text), "EAR %.2f MAR %.2f PERCLOS %.0f%% yawns/min %.1f",
+                 state.eyeAspectRatio, state.mouthAspectRatio, state.perclos * 100.f, state.yawnsPerMinute);
+        cv::putText(m_preview, text, cv::Point(10, 20), cv::FONT_HERSHEY_SIMPLEX, 0.5,
+                    state.eyesClosed ? cv::Scalar(0, 0, 255) : cv::Scalar(0, 255, 0), 1);
+
+        if (faceFeatures->hasHeadPose[state.face]) {
+            snprintf(text, sizeof(text), "yaw %.0f pitch %.0f roll %.0f",
+                     faceFeatures->headYaw[state.face], faceFeatures->headPitch[state.face],
+                     faceFeatures->headRoll[state.face]);
+            cv::putText(m_preview, text, cv::Point(10, 40), cv::FONT_HERSHEY_SIMPLEX, 0.5,
+                        cv::Scalar(0, 255, 0), 1);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "FaceResults.h"
+
+/**
+ * @brief The Display class shows the frames with their results, on its own thread
+ * The capture loop only hands over the latest frame and results with show(), which never waits for rendering :
+ * a frame given while the previous one is still drawn replaces it, and is shown at most maxFps times per second.
+ *
+ * Drawing is done on a preview downscaled by previewScale (never on the captured frame, which the stages share),
+ * landmarks are written directly to the preview pixels.
+ *
+ * All HighGUI calls (window, imshow, key polling) are made by the display thread.
+ */
+class Display
+{
+public:
+    /**
+     * @brief Display
+     * @param windowName
+     * @param previewScale size of the preview relative to the frames, in (0, 1]
+     * @param maxFps at most that many frames are rendered per second
+     */
+    Display(const std::string& windowName, double previewScale, double maxFps);
+    Display(const Display&) = delete;
+
+    // closes the window and stops the thread
+    ~Display();
+
+    /**
+     * @brief show hand over the latest frame and results to the display thread
+     * @param frame its image must not be modified afterwards
+     * @param rects latest detection, may be null
+     * @param faceFeatures latest face features, may be null
+     */
+    void show(const Frame& frame,
+              std::shared_ptr<const FaceResults> rects,
+              std::shared_ptr<const FaceResults> faceFeatures);
+
+    /**
+     * @brief quitRequested
+     * @return true once a key was pressed in the window
+     */
+    bool quitRequested() const { return m_quitRequested.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+    /**
+     * @brief render draw rects and faceFeatures on a preview of frame, to m_preview
+     */
+    void render(const Frame& frame, const FaceResults* rects, const FaceResults* faceFeatures);
+
+    const std::string m_windowName;
+    const double m_previewScale;
+    const double m_minPeriod;
+
+    // latest frame and results not yet rendered, guarded by m_mutex
+    Frame m_frame;
+    std::shared_ptr<const FaceResults> m_rects;
+    std::shared_ptr<const FaceResults> m_faceFeatures;
+    bool m_hasNew;
+    bool m_stop;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+
+    // only used by the display thread
+    cv::Mat m_preview;
+
+    std::atomic<bool> m_quitRequested;
+    std::thread m_thread;
+};
+
+#endif // DISPLAY_H
@@ -0,0 +1,31 @@
+#ifndef DLIBUTILS_H
+#define DLIBUTILS_H
+
+// only for the dlib backends : dlib headers reference symbols of the dlib library
+// (build consistency checks), that a single configuration build without them does not link
+
+#include <opencv2/core/types.hpp>
+
+#include <dlib/geometry/rectangle.h>
+
+/**
+ * @brief dlibRectangleToOpenCV
+ * @param r dlib rectangle
+ * @return an OpenCV rectangle converted from the dlib rectangle passed as param
+ */
+inline cv::Rect dlibRectangleToOpenCV(const dlib::rectangle & r)
+{
+    return cv::Rect(cv::Point2f(r.left(), r.top()), cv::Point2f(r.right() + 1, r.bottom() + 1));
+}
+
+/**
+ * @brief openCVRectangleToDlib
+ * @param r OpenCV rectangle
+ * @return an dlib rectangle converted from the OpenCV rectangle passed as param
+ */
+inline dlib::rectangle openCVRectangleToDlib(const cv::Rect & r)
+{
+    return dlib::rectangle((long)r.tl().x, (long)r.tl().y, (long)r.br().x - 1, (long)r.br().y - 1);
+}
+
+#endif // DLIBUTILS_H
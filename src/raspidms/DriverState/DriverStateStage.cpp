@@ -0,0 +1,117 @@
+#include "DriverState/DriverStateStage.h"
+
+#include <algorithm>
+#include <cmath>
+
+const double INITIAL_AVERAGE_TIME = 0.0001;
+
+// eyes are closed below this eye aspect ratio
+const float EYES_CLOSED_EAR_THRESHOLD = 0.2f;
+
+// yawn starts above, and stops below these mouth aspect ratios
+const float YAWN_START_MAR_THRESHOLD = 0.6f;
+const float YAWN_STOP_MAR_THRESHOLD = 0.4f;
+
+// sliding windows duration, and capacity (enough for 60 fps)
+const double PERCLOS_WINDOW = 60.;
+const double YAWNS_WINDOW = 60.;
+const size_t WINDOWS_CAPACITY = 4096;
+
+static inline float distance(const FaceResults& faces, int face, int a, int b) {
+    const float dx = faces.landmarksX[face][a] - faces.landmarksX[face][b];
+    const float dy = faces.landmarksY[face][a] - faces.landmarksY[face][b];
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+// (|p2 - p6| + |p3 - p5|) / (2 |p1 - p4|)
+static float eyeAspectRatio(const FaceResults& faces, int face, const int (&eye)[6]) {
+    const float width = distance(faces, face, eye[0], eye[3]);
+    if (width <= 0.f)
+        return 0.f;
+    return (distance(faces, face, eye[1], eye[5]) + distance(faces, face, eye[2], eye[4])) / (2.f * width);
+}
+
+// mean of vertical openings / width
+static float mouthAspectRatio(const FaceResults& faces, int face, const int (&mouth)[8]) {
+    const float width = distance(faces, face, mouth[0], mouth[1]);
+    if (width <= 0.f)
+        return 0.f;
+    const float height = distance(faces, face, mouth[2], mouth[3])
+            + distance(faces, face, mouth[4], mouth[5])
+            + distance(faces, face, mouth[6], mouth[7]);
+    return height / (3.f * width);
+}
+
+DriverStateStage::DriverStateStage(std::shared_ptr<SharedQueue<FaceResultsPtr>> inFaceFeatures,
+                                   std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures)
+    : ResultsStage("driver_state", STAGE_DRIVER_STATE, INITIAL_AVERAGE_TIME, true,
+                   inFaceFeatures, outFaceFeatures),
+      m_eyesClosedWindow(PERCLOS_WINDOW, WINDOWS_CAPACITY),
+      m_yawnsWindow(YAWNS_WINDOW, WINDOWS_CAPACITY),
+      m_lastTimestamp(0.),
+      m_eyesClosedSince(0.),
+      m_eyesClosed(false),
+      m_yawning(false)
+{
+
+}
+
+void DriverStateStage::process(FaceResults& faces) {
+    DriverState& state = faces.driverState;
+    state.valid = false;
+
+    const LandmarksIndexMap* indexMap = landmarksIndexMap(faces.numLandmarks);
+    if (!indexMap)
+        return;
+
+    // the driver is the biggest face
+    int driver = -1;
+    float driver_area = 0.f;
+    for (int face = 0; face < faces.numFaces; ++face) {
+        const float area = faces.box(face).area();
+        if (faces.hasLandmarks[face] && area > driver_area) {
+            driver = face;
+            driver_area = area;
+        }
+    }
+
+    if (driver < 0)
+        return;
+
+    const float ear = 0.5f * (eyeAspectRatio(faces, driver, indexMap->rightEye)
+                              + eyeAspectRatio(faces, driver, indexMap->leftEye));
+    const float mar = mouthAspectRatio(faces, driver, indexMap->mouth);
+
+    // results computed in parallel may come out of order, or again for the same frame :
+    // only newer frames update the windows, once each, so that PERCLOS is not weighted by reprocessing
+    const double timestamp = faces.frame.timestamp;
+    if (timestamp > m_lastTimestamp) {
+        m_lastTimestamp = timestamp;
+
+        const bool eyes_closed = ear < EYES_CLOSED_EAR_THRESHOLD;
+        if (eyes_closed && !m_eyesClosed)
+            m_eyesClosedSince = timestamp;
+        m_eyesClosed = eyes_closed;
+        m_eyesClosedWindow.push(timestamp, eyes_closed ? 1. : 0.);
+
+        // a yawn is counted once, when it starts
+        const bool yawn_start = !m_yawning && mar > YAWN_START_MAR_THRESHOLD;
+        if (yawn_start)
+            m_yawning = true;
+        else if (m_yawning && mar < YAWN_STOP_MAR_THRESHOLD)
+            m_yawning = false;
+        m_yawnsWindow.push(timestamp, yawn_start ? 1. : 0.);
+    }
+
+    state.valid = true;
+    state.face = driver;
+    state.eyeAspectRatio = ear;
+    state.mouthAspectRatio = mar;
+    state.eyesClosed = m_eyesClosed;
+    state.eyesClosedDuration = m_eyesClosed ? m_lastTimestamp - m_eyesClosedSince : 0.;
+    state.yawning = m_yawning;
+    state.perclos = static_cast<float>(m_eyesClosedWindow.mean());
+    // until the window is filled, extrapolate from the time it covers
+    const double yawns_span = std::max(m_yawnsWindow.span(), 1.);
+    state.yawnsPerMinute = static_cast<float>(m_yawnsWindow.sum() * 60. / std::min(yawns_span, YAWNS_WINDOW));
+}
@@ -0,0 +1,41 @@
+#ifndef DRIVERSTATESTAGE_H
+#define DRIVERSTATESTAGE_H
+
+#include <memory>
+
+#include "DriverState/LandmarksIndexMap.h"
+#include "ResultsStage.h"
+#include "RingBuffer.h"
+
+/**
+ * @brief The DriverStateStage class computes the drowsiness indicators of the driver
+ * from its landmarks (dlib 68 or mediapipe 468), and writes them to FaceResults::driverState :
+ * - eye aspect ratio and mouth aspect ratio of the frame
+ * - PERCLOS (percentage of eye closure) and yawns per minute over sliding windows
+ * Windows are updated in O(1) per frame with running sums.
+ */
+class DriverStateStage : public ResultsStage
+{
+public:
+    DriverStateStage(std::shared_ptr<SharedQueue<FaceResultsPtr>> inFaceFeatures,
+                     std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures);
+    DriverStateStage(const DriverStateStage&) = delete;
+
+protected:
+    /**
+     * override void ResultsStage::process(FaceResults&);
+     * fill faces.driverState
+     */
+    virtual void process(FaceResults& faces) override;
+
+private:
+    // state over time, shared by all threads (process is serialized)
+    SlidingWindow m_eyesClosedWindow;
+    SlidingWindow m_yawnsWindow;
+    double m_lastTimestamp;
+    double m_eyesClosedSince;
+    bool m_eyesClosed;
+    bool m_yawning;
+};
+
+#endif // DRIVERSTATESTAGE_H
@@ -0,0 +1,54 @@
+#ifndef LANDMARKSINDEXMAP_H
+#define LANDMARKSINDEXMAP_H
+
+/**
+ * @brief LandmarksIndexMap gives the indices of the landmarks used by the driver state computation
+ * for a given face mesh model
+ *
+ * Eyes follow the usual eye aspect ratio numbering p1..p6 :
+ * p1, p4 the corners, (p2, p6) and (p3, p5) the vertical pairs
+ * Mouth is {left corner, right corner, then 3 vertical pairs (top, bottom)} of the inner lips
+ * Right / left are the ones of the subject
+ * Pose is {nose tip, chin, image left eye outer corner, image right eye outer corner,
+ * image left mouth corner, image right mouth corner}, matched against a canonical 3D face by HeadPoseStage
+ */
+struct LandmarksIndexMap {
+    int numLandmarks;
+    int rightEye[6];
+    int leftEye[6];
+    int mouth[8];
+    int pose[6];
+};
+
+// dlib 68 points (iBUG 300-W)
+static const LandmarksIndexMap kDlib68IndexMap = {
+    68,
+    {36, 37, 38, 39, 40, 41},
+    {42, 43, 44, 45, 46, 47},
+    {60, 64, 61, 67, 62, 66, 63, 65},
+    {30, 8, 36, 45, 48, 54},
+};
+
+// mediapipe face mesh 468 points
+static const LandmarksIndexMap kMediaPipe468IndexMap = {
+    468,
+    {33, 160, 158, 133, 153, 144},
+    {362, 385, 387, 263, 373, 380},
+    {78, 308, 81, 178, 13, 14, 311, 402},
+    {1, 152, 33, 263, 61, 291},
+};
+
+/**
+ * @brief landmarksIndexMap
+ * @param numLandmarks
+ * @return the index map of the face mesh giving numLandmarks landmarks, nullptr if unknown
+ */
+inline const LandmarksIndexMap* landmarksIndexMap(int numLandmarks) {
+    if (numLandmarks == kDlib68IndexMap.numLandmarks)
+        return &kDlib68IndexMap;
+    if (numLandmarks == kMediaPipe468IndexMap.numLandmarks)
+        return &kMediaPipe468IndexMap;
+    return nullptr;
+}
+
+#endif // LANDMARKSINDEXMAP_H
@@ -3,40 +3,56 @@
 #include <dlib/opencv/cv_image.h>
 #include <dlib/serialize.h>
 
+#include <algorithm>
 #include <inttypes.h>
+#include "DlibUtils.h"
 #include "Utils.h"
 
 FaceFeaturesDlib::FaceFeaturesDlib(const std::string & path)
     : IFaceFeatures(path),
       m_shapePredictor(),
+      m_grayBuffer(),
       m_id(getUniqueId())
 {
     dlib::deserialize(m_path) >> m_shapePredictor;
     std::cout << "building face feature predictor (dlib) complete" << std::endl;
 }
 
-PointsList FaceFeaturesDlib::operator()(const cv::Mat & frame,
-                                                std::vector<cv::Rect>& roi) {
-    timeMark(m_id);
-    cv::Mat frameCopy = frame.clone();
+void FaceFeaturesDlib::operator()(const cv::Mat & frame, FaceResults& faces) {
+    PhaseTimer timer(m_phaseTimings);
 
-    dlib::array2d<dlib::bgr_pixel> dlibFrame;
-    dlib::assign_image(dlibFrame, dlib::cv_image<dlib::bgr_pixel>(frameCopy));
+    // Grayscale buffer is allocated once for the frame size,
+    // and only the part of it around each face is written
+    m_grayBuffer.create(frame.size(), CV_8UC1);
+    const cv::Rect frameRect(0, 0, frame.cols, frame.rows);
 
-    PointsList ret;
-    for (auto& region : roi) {
-        std::vector<cv::Point2f> points;
-        dlib::full_object_detection shape = m_shapePredictor(dlibFrame,
-                                                             openCVRectangleToDlib(region));
+    for (int face = 0; face < faces.numFaces; ++face) {
+        const cv::Rect box(faces.topLeft(face), faces.bottomRight(face));
 
-        uint32_t num_parts = shape.num_parts();
+        // the shape predictor may sample pixels a bit outside of the box
+        const int margin_x = box.width / 4;
+        const int margin_y = box.height / 4;
+        const cv::Rect region = cv::Rect(box.x - margin_x, box.y - margin_y,
+                                         box.width + 2 * margin_x, box.height + 2 * margin_y) & frameRect;
+        if (region.empty())
+            continue;
+
+        cv::Mat grayRegion = m_grayBuffer(cv::Rect(0, 0, region.width, region.height));
+        cv::cvtColor(frame(region), grayRegion, cv::COLOR_BGR2GRAY);
+        timer.mark(PHASE_PREPROCESS);
+
+        dlib::full_object_detection shape = m_shapePredictor(dlib::cv_image<unsigned char>(grayRegion),
+                                                             openCVRectangleToDlib(box - region.tl()));
+        timer.mark(PHASE_INFERENCE);
+
+        uint32_t num_parts = std::min<uint32_t>(shape.num_parts(), MAX_LANDMARKS);
         for(uint32_t i = 0; i < num_parts; ++i) {
             auto p = shape.part(i);
-            points.push_back(cv::Point2f(p.x(), p.y()));
+            faces.setLandmark(face, i, cv::Point2f(p.x() + region.x, p.y() + region.y));
         }
 
-        ret.push_back(points);
+        faces.numLandmarks = num_parts;
+        faces.hasLandmarks[face] = true;
+        timer.mark(PHASE_POSTPROCESS);
     }
-
-    return ret;
 }
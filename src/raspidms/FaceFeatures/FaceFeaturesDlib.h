@@ -4,17 +4,17 @@
 #include "FaceFeatures/IFaceFeatures.h"
 #include <dlib/image_processing.h>
 
-class FaceFeaturesDlib : public IFaceFeatures
+class FaceFeaturesDlib final : public IFaceFeatures
 {
 public:
     FaceFeaturesDlib(const std::string & path);
 
-    virtual PointsList operator()(const cv::Mat & frame,
-                                          std::vector<cv::Rect>& roi) override;
+    virtual void operator()(const cv::Mat & frame, FaceResults& faces) override;
 
 
 private:
     dlib::shape_predictor m_shapePredictor;
+    cv::Mat m_grayBuffer;
     const long m_id;
 };
 
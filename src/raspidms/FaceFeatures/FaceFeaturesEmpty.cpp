@@ -6,9 +6,8 @@ FaceFeaturesEmpty::FaceFeaturesEmpty(const std::string& path) : IFaceFeatures(pa
 
 }
 
-PointsList FaceFeaturesEmpty::operator()(const cv::Mat& frame,
-                                                std::vector<cv::Rect>& roi) {
-    PointsList ret;
+void FaceFeaturesEmpty::operator()(const cv::Mat& frame, FaceResults& faces) {
+    (void)frame;
+    (void)faces;
     std::cerr << "Warning: using FaceFeatureEmpty" << std::endl;
-    return ret;
 }
@@ -3,13 +3,12 @@
 
 #include "FaceFeatures/IFaceFeatures.h"
 
-class FaceFeaturesEmpty : public IFaceFeatures
+class FaceFeaturesEmpty final : public IFaceFeatures
 {
 public:
     FaceFeaturesEmpty(const std::string& path = std::string());
 
-    virtual PointsList operator()(const cv::Mat & frame,
-                                          std::vector<cv::Rect>& roi) override;
+    virtual void operator()(const cv::Mat & frame, FaceResults& faces) override;
 private:
     const long m_id;
 };
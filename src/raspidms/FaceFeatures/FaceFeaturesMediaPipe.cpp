@@ -14,6 +14,8 @@
 #include "tensorflow/lite/model.h"
 #include "tensorflow/lite/optional_debug_tools.h"
 
+#include <algorithm>
+#include <cmath>
 #include <inttypes.h>
 #include <map>
 #include <thread>
@@ -33,12 +35,16 @@ static const std::map<std::string, double> kOutputParameters = {
     {"detection_threshold", 0.5},
 };
 
-static tflite::FlatBufferModel& getModel(const std::string & path) {
-    static std::unique_ptr<tflite::FlatBufferModel> flatBufferModel(nullptr);
-    if (!flatBufferModel)
-        flatBufferModel = tflite::FlatBufferModel::BuildFromFile(path.c_str(), nullptr);
-
-    return *flatBufferModel;
+/**
+ * @brief getModel load the model once, shared by every interpreter (models are preloaded from several threads at once)
+ * @param path
+ * @return the model, null if it could not be loaded
+ */
+static tflite::FlatBufferModel* getModel(const std::string & path) {
+    // static initialization is thread safe : one load, the other threads wait for it
+    static const std::unique_ptr<tflite::FlatBufferModel> flatBufferModel =
+        tflite::FlatBufferModel::BuildFromFile(path.c_str(), nullptr);
+    return flatBufferModel.get();
 }
 
 static tflite::ops::builtin::BuiltinOpResolver& getResolver() {
@@ -46,12 +52,133 @@ static tflite::ops::builtin::BuiltinOpResolver& getResolver() {
     return resolver;
 }
 
+/**
+ * @brief faceToInputAffine
+ * @param faces
+ * @param face index of the face in faces
+ * @param roiScale scale applied around the box center
+ * @param inputSize size of the model input
+ * @return the affine transform mapping model input coordinates to frame coordinates.
+ * The box is scaled by roiScale, and rotated by the roll given by the eyes keypoints when present
+ */
+static cv::Matx23f faceToInputAffine(const FaceResults& faces, int face, float roiScale, cv::Size inputSize) {
+    const cv::Point2f center = (faces.topLeft(face) + faces.bottomRight(face)) * 0.5f;
+    const float scale_x = roiScale * (faces.boxRight[face] - faces.boxLeft[face]) / inputSize.width;
+    const float scale_y = roiScale * (faces.boxBottom[face] - faces.boxTop[face]) / inputSize.height;
+
+    float angle = 0.f;
+    if (faces.numKeypoints >= 2) {
+        // keypoint 0 is the right eye, on the left side of the image, keypoint 1 the left eye
+        const cv::Point2f eyes = faces.keypoint(face, 1) - faces.keypoint(face, 0);
+        angle = std::atan2(eyes.y, eyes.x);
+    }
+    const float c = std::cos(angle);
+    const float s = std::sin(angle);
+
+    const float a = c * scale_x;
+    const float b = -s * scale_y;
+    const float d = s * scale_x;
+    const float e = c * scale_y;
+    const float half_w = inputSize.width * 0.5f;
+    const float half_h = inputSize.height * 0.5f;
+
+    return cv::Matx23f(a, b, center.x - a * half_w - b * half_h,
+                       d, e, center.y - d * half_w - e * half_h);
+}
+
+/**
+ * @brief warpToInputTensor fused crop + rotation + resize + BGR2RGB + normalization.
+ * Samples (bilinear) the BGR frame through the affine for each pixel of the model input,
+ * and writes RGB floats in [-1, 1] directly into dst. Only the pixels under the face are read.
+ * Outside of the frame, pixels are black.
+ * @param frame BGR CV_8UC3
+ * @param affine model input coordinates to frame coordinates
+ * @param dst float tensor of inputSize.area() * 3
+ * @param inputSize
+ */
+static void warpToInputTensor(const cv::Mat& frame, const cv::Matx23f& affine, float* dst, cv::Size inputSize) {
+    const float norm = 1.f / 127.f; //see mediapipe Face Detection model card
+    const int max_x = frame.cols - 1;
+    const int max_y = frame.rows - 1;
+    static const uint8_t black[3] = {0, 0, 0};
+
+    for (int y = 0; y < inputSize.height; ++y) {
+        // sample at pixel centers
+        const float v = y + 0.5f;
+        float src_x = affine(0, 0) * 0.5f + affine(0, 1) * v + affine(0, 2) - 0.5f;
+        float src_y = affine(1, 0) * 0.5f + affine(1, 1) * v + affine(1, 2) - 0.5f;
+
+        for (int x = 0; x < inputSize.width; ++x, dst += 3, src_x += affine(0, 0), src_y += affine(1, 0)) {
+            const int x0 = static_cast<int>(std::floor(src_x));
+            const int y0 = static_cast<int>(std::floor(src_y));
+            const float fx = src_x - x0;
+            const float fy = src_y - y0;
+
+            const uint8_t* p00;
+            const uint8_t* p01;
+            const uint8_t* p10;
+            const uint8_t* p11;
+            if (x0 >= 0 && y0 >= 0 && x0 < max_x && y0 < max_y) {
+                p00 = frame.ptr<uint8_t>(y0) + x0 * 3;
+                p01 = p00 + 3;
+                p10 = frame.ptr<uint8_t>(y0 + 1) + x0 * 3;
+                p11 = p10 + 3;
+            } else {
+                auto tap = [&](int tx, int ty) -> const uint8_t* {
+                    if (tx < 0 || ty < 0 || tx > max_x || ty > max_y)
+                        return black;
+                    return frame.ptr<uint8_t>(ty) + tx * 3;
+                };
+                p00 = tap(x0, y0);
+                p01 = tap(x0 + 1, y0);
+                p10 = tap(x0, y0 + 1);
+                p11 = tap(x0 + 1, y0 + 1);
+            }
+
+            const float w00 = (1.f - fx) * (1.f - fy);
+            const float w01 = fx * (1.f - fy);
+            const float w10 = (1.f - fx) * fy;
+            const float w11 = fx * fy;
+
+            // BGR -> RGB
+            for (int c = 0; c < 3; ++c) {
+                const float value = w00 * p00[2 - c] + w01 * p01[2 - c] + w10 * p10[2 - c] + w11 * p11[2 - c];
+                dst[c] = value * norm - 1.f;
+            }
+        }
+    }
+}
+
 FaceFeaturesMediaPipe::FaceFeaturesMediaPipe(const std::string & path)
     : IFaceFeatures(path),
       m_interpreter(nullptr),
+      m_batchSize(0),
+      m_batchSupported(true),
       m_id(getUniqueId())
 {
+    // the interpreter is built here rather than on the first frame, for its creation to count as loading
+    tflite::FlatBufferModel* model = getModel(m_path);
+    if (!model) {
+        std::cout << "Error loading model " << m_path << std::endl;
+        return;
+    }
+    auto& resolver = getResolver();
 
+    tflite::InterpreterBuilder builder(*model, resolver);
+    if (builder(&m_interpreter) != kTfLiteOk) {
+        std::cout << "Error building interpreter" << std::endl;
+        m_interpreter.reset();
+        return;
+    } else {
+        printModelIOTensorsInfo();
+    }
+
+    if (m_interpreter->AllocateTensors() != kTfLiteOk) {
+        m_interpreter.reset();
+        std::cout << "Error allocating tensors" << std::endl;
+        return;
+    }
+    m_batchSize = 1;
 }
 
 void FaceFeaturesMediaPipe::printModelIOTensorsInfo() {
@@ -101,85 +228,119 @@ void FaceFeaturesMediaPipe::printModelIOTensorsInfo() {
     }
 }
 
-PointsList FaceFeaturesMediaPipe::operator()(const cv::Mat & frame,
-                                                std::vector<cv::Rect>& roi) {
-    PointsList ret;
-    if (frame.empty()) {
-        return ret;
+bool FaceFeaturesMediaPipe::resizeBatch(int batchSize) {
+    if (batchSize == m_batchSize)
+        return true;
+
+    const int input = m_interpreter->inputs()[0];
+    const std::vector<int> dims = {batchSize,
+                                   static_cast<int>(kInputParameters.at("input_size_height")),
+                                   static_cast<int>(kInputParameters.at("input_size_width")),
+                                   3};
+
+    if (m_interpreter->ResizeInputTensor(input, dims) != kTfLiteOk
+            || m_interpreter->AllocateTensors() != kTfLiteOk) {
+        std::cout << "Error resizing input tensor to batch size " << batchSize << std::endl;
+        m_batchSize = 0;
+        return false;
     }
 
-    if (!m_interpreter) {
-        auto& model = getModel(m_path);
-        auto& resolver = getResolver();
+    // Some exports of the model reshape to a fixed batch of 1 internally,
+    // in which case the output does not follow the input batch size
+    TfLiteTensor* output = m_interpreter->output_tensor(0);
+    if (!output || !output->dims || output->dims->size == 0 || output->dims->data[0] != batchSize) {
+        std::cout << "Model output does not follow batch size " << batchSize << std::endl;
+        m_batchSize = 0;
+        return false;
+    }
 
-        tflite::InterpreterBuilder builder(model, resolver);
-        if (builder(&m_interpreter) != kTfLiteOk) {
-            std::cout << "Error building interpreter" << std::endl;
-            m_interpreter.reset();
-            return ret;
-        } else {
-            printModelIOTensorsInfo();
-        }
+    m_batchSize = batchSize;
+    return true;
+}
+
+void FaceFeaturesMediaPipe::operator()(const cv::Mat & frame, FaceResults& faces) {
+    if (frame.empty() || faces.numFaces == 0) {
+        return;
+    }
+
+    // not loaded (see the constructor)
+    if (!m_interpreter)
+        return;
 
-        if (m_interpreter->AllocateTensors() != kTfLiteOk) {
+    PhaseTimer timer(m_phaseTimings);
+
+    const int num_faces = faces.numFaces;
+
+    // Run all faces in one Invoke() when the model accepts a batch,
+    // otherwise fall back to one Invoke() per face
+    int batch_size = m_batchSupported ? num_faces : 1;
+    if (!resizeBatch(batch_size)) {
+        m_batchSupported = false;
+        batch_size = 1;
+        if (!resizeBatch(batch_size)) {
             m_interpreter.reset();
-            std::cout << "Error allocating tensors" << std::endl;
-            return ret;
+            return;
         }
     }
 
-    cv::Mat frameCopy = frame.clone();
-    cv::cvtColor(frameCopy, frameCopy, cv::COLOR_BGR2RGB);
-
     const float roi_scale = kInputParameters.at("roi_scale");
-    const int num_landmarks = kOutputParameters.at("num_landmarks");
+    const cv::Size input_size(kInputParameters.at("input_size_width"), kInputParameters.at("input_size_height"));
+    const int input_stride = input_size.area() * 3;
+    const int num_landmarks = std::min(static_cast<int>(kOutputParameters.at("num_landmarks")), MAX_LANDMARKS);
     const float detection_threshold = kOutputParameters.at("detection_threshold");
 
-    for (auto region : roi) {
-
-        // scale up roi
-        float new_left   = std::max(0.f,                   roi_scale * region.tl().x + (1.f - roi_scale) * region.br().x);
-        float new_right  = std::min((float)frameCopy.cols, roi_scale * region.br().x + (1.f - roi_scale) * region.tl().x);
-        float new_top    = std::max(0.f,                   roi_scale * region.tl().y + (1.f - roi_scale) * region.br().y);
-        float new_bottom = std::min((float)frameCopy.rows, roi_scale * region.br().y + (1.f - roi_scale) * region.tl().y);
-
-        region = cv::Rect(cv::Point2f(new_left, new_top), cv::Point2f(new_right, new_bottom));
-        float roi2image_width_scale = (float)region.width / kInputParameters.at("input_size_width");
-        float roi2image_height_scale = (float)region.height / kInputParameters.at("input_size_height");
+    // model input to frame transform of each face, used both ways
+    cv::Matx23f affines[MAX_FACES];
+    for (int face = 0; face < num_faces; ++face) {
+        affines[face] = faceToInputAffine(faces, face, roi_scale, input_size);
+    }
 
-        cv::Mat croppedFrame = frameCopy(region);
-        cv::resize(croppedFrame, croppedFrame, cv::Size(kInputParameters.at("input_size_width"), kInputParameters.at("input_size_height"))); //mediapipe face_detection_short_range input size is 128x128
-        croppedFrame.convertTo(croppedFrame, CV_32FC3, 1.0 / 127, -1.0); //see mediapipe Face Detection model card*/
+    faces.numLandmarks = num_landmarks;
 
-        float* data = reinterpret_cast<float*>(croppedFrame.data);
+    for (int first = 0; first < num_faces; first += batch_size) {
         float* input_f32 = m_interpreter->typed_input_tensor<float>(0);
-        // croppedFrame.total() * croppedFrame.channels() = (192 * 192) * 3 = num of floats
-        for (size_t i = 0; i < croppedFrame.total() * croppedFrame.channels(); i++) {
-            input_f32[i] = data[i];
+
+        for (int j = 0; j < batch_size; ++j) {
+            warpToInputTensor(frame, affines[first + j], input_f32 + j * input_stride, input_size);
         }
+        timer.mark(PHASE_PREPROCESS);
 
         m_interpreter->Invoke();
+        timer.mark(PHASE_INFERENCE);
 
         float* output_f32_0 = m_interpreter->typed_output_tensor<float>(0);
         float* output_f32_1 = m_interpreter->typed_output_tensor<float>(1);
 
         if (!output_f32_0 || !output_f32_1) {
             std::cout << "Error output tensors" << std::endl;
-            return ret;
+            return;
         }
 
-        // output_f32_1 is of dim [1, 1, 1, 1] so just one float
-        if (*output_f32_1 > detection_threshold) {
-            ret.emplace_back(num_landmarks, cv::Point2f());
-            auto& points = ret.back();
+        // output(0) is of dim [N, 1, 1, num_landmarks * 3]
+        // output(1) is of dim [N, 1, 1, 1] so just one float per face
+        for (int j = 0; j < batch_size; ++j) {
+            if (output_f32_1[j] <= detection_threshold)
+                continue;
+
+            const int face = first + j;
+            const cv::Matx23f& affine = affines[face];
+            const float* landmarks = output_f32_0 + j * num_landmarks * 3;
+            float* points_x = faces.landmarksX[face];
+            float* points_y = faces.landmarksY[face];
+            float* points_z = faces.landmarksZ[face];
+            // z is in the same unit as x in the model input, scale it like x
+            const float z_scale = std::sqrt(affine(0, 0) * affine(0, 0) + affine(1, 0) * affine(1, 0));
+
             for (int i = 0; i < num_landmarks; ++i) {
                 // i * 3 because each landmarks is (x, y, z)
-                // z is discarded here
-                points[i] = cv::Point2f(output_f32_0[i * 3] * roi2image_width_scale + region.x,
-                        output_f32_0[i * 3 + 1] * roi2image_height_scale + region.y);
+                const float x = landmarks[i * 3];
+                const float y = landmarks[i * 3 + 1];
+                points_x[i] = affine(0, 0) * x + affine(0, 1) * y + affine(0, 2);
+                points_y[i] = affine(1, 0) * x + affine(1, 1) * y + affine(1, 2);
+                points_z[i] = landmarks[i * 3 + 2] * z_scale;
             }
+            faces.hasLandmarks[face] = true;
         }
+        timer.mark(PHASE_POSTPROCESS);
     }
-
-    return ret;
 }
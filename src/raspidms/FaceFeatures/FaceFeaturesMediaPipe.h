@@ -6,17 +6,26 @@
 #include "tensorflow/lite/interpreter.h"
 
 
-class FaceFeaturesMediaPipe : public IFaceFeatures
+class FaceFeaturesMediaPipe final : public IFaceFeatures
 {
 public:
     FaceFeaturesMediaPipe(const std::string & path);
-    virtual PointsList operator()(const cv::Mat & frame,
-                                          std::vector<cv::Rect>& roi) override;
+    virtual void operator()(const cv::Mat & frame, FaceResults& faces) override;
 
     void printModelIOTensorsInfo();
 
 private:
+    /**
+     * @brief resizeBatch resize the input tensor to [batchSize, 192, 192, 3]
+     * Tensors are only reallocated when batchSize differs from the current one
+     * @param batchSize
+     * @return false if the interpreter can not run with such a batch size
+     */
+    bool resizeBatch(int batchSize);
+
     std::unique_ptr<tflite::Interpreter> m_interpreter;
+    int m_batchSize;
+    bool m_batchSupported;
     const long m_id;
 };
 
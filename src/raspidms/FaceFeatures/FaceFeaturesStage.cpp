@@ -1,108 +1,157 @@
 #include "FaceFeatures/FaceFeaturesStage.h"
 
+// every face mesh, or the only one compiled in (BuildConfig.h)
+#ifdef RASPIDMS_ALL_FACE_MESHES
 #include "FaceFeatures/FaceFeaturesDlib.h"
 #include "FaceFeatures/FaceFeaturesMediaPipe.h"
 #include "FaceFeatures/FaceFeaturesEmpty.h"
+#endif
 
+#include "Stats/AllocTracker.h"
+#include "Tracing/Tracer.h"
 #include "Utils.h"
 
 const size_t MAX_OUT_QUEUE_SIZE = 2;
 const double INITIAL_AVERAGE_TIME = 0.1;
 const double AVERAGE_ALPHA = 0.1;
 
+// boxes of the last detection with faces are reused when a detection finds none, until they are that old (seconds)
+const double MAX_REUSED_ROI_AGE = 0.3;
+
 FaceFeaturesStage::FaceFeaturesStage(const std::string& detectorName,
-                                     std::shared_ptr<SharedQueue<cv::Mat>> inFrames,
-                                     std::shared_ptr<SharedQueue<PointsList>> regionOfInterests,
-                                     std::shared_ptr<SharedQueue<PointsList>> outFaceFeatures)
+                                     std::shared_ptr<SharedQueue<Frame>> inFrames,
+                                     std::shared_ptr<SharedQueue<FaceResultsPtr>> regionOfInterests,
+                                     std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures)
     : m_detectorName(detectorName),
       m_inFrames(inFrames),
       m_regionOfInterests(regionOfInterests),
       m_outFaceFeatures(outFaceFeatures),
-      m_mutex(),
+      m_lastValidRoi(),
+      m_resultsPool(),
+      m_detectors("FaceFeaturesStage", resolveFactory(detectorName)),
       m_averageTime(INITIAL_AVERAGE_TIME),
-      m_averageAlpha(AVERAGE_ALPHA)
+      m_averageAlpha(AVERAGE_ALPHA),
+      m_primaryFaceOnly(false)
 {
 
 }
 
 void FaceFeaturesStage::operator()(int threadId) {
-    std::cout << "FaceFeaturesStage thread id " << threadId << std::endl;
-    std::shared_ptr<IFaceFeatures> detector = getNextDetector(threadId);
+    AllocScope alloc_scope(ALLOC_FACE_FEATURES);
+    Frame frame;
+    FaceResultsPtr rois;
+    {
+        TRACE_SPAN("face_features.wait");
+        // try pop without emptying
+        if (m_inFrames->size() > 1) {
+            m_inFrames->pop_front_wait(frame);
+        } else {
+            frame = m_inFrames->front_wait();
+        }
 
-    cv::Mat frame;
+        if (frame.image.empty()) {
+            std::cout << "FaceFeaturesStage: " << "empty frame" << std::endl;
+            return;
+        }
 
-    // try pop without emptying
-    if (m_inFrames->size() > 1) {
-        m_inFrames->pop_front_wait(frame);
-    } else {
-        frame = m_inFrames->front_wait();
+        // Wait for roi
+        rois = m_regionOfInterests->front_wait();
     }
 
-    if (frame.empty()) {
-        std::cout << "FaceFeaturesStage: " << "empty frame" << std::endl;
-        return;
+    if (rois->numFaces > 0) {
+        std::atomic_store(&m_lastValidRoi, rois);
+    } else {
+        const FaceResultsPtr last_valid_roi = std::atomic_load(&m_lastValidRoi);
+        if (last_valid_roi && frame.timestamp - last_valid_roi->detectionTimestamp <= MAX_REUSED_ROI_AGE)
+            rois = last_valid_roi;
     }
 
-    // Wait for roi
-    PointsList pl_rois = m_regionOfInterests->front_wait();
+    FaceResultsPtr faces_features = process(frame, *rois, threadId);
 
-    if (pl_rois.size() == 0) {
-        pl_rois = m_lastValidRoi;
-    } else {
-        m_lastValidRoi = pl_rois;
-    }
+    // passed on even without face or landmarks, so that the driver is seen gone (DriverStateStage, AlertEngine)
+    m_outFaceFeatures->push_back(std::move(faces_features));
 
-    std::vector<cv::Rect> rois;
-    for (auto& head : pl_rois) {
-        rois.push_back(cv::Rect(head[0], head[1]));
-    }
+    if (m_outFaceFeatures->size() > MAX_OUT_QUEUE_SIZE)
+        m_outFaceFeatures->pop_front_no_wait();
+}
 
-    timeMark(threadId);
-    // Detect the faces features
-    PointsList faces_features = (*detector)(frame, rois);
+FaceResultsPtr FaceFeaturesStage::process(const Frame& frame, const FaceResults& rois, int threadId) {
+    TRACE_SPAN("face_features");
+    AllocScope alloc_scope(ALLOC_FACE_FEATURES);
+    FaceMeshType* const detector = m_detectors.get(threadId);
 
-    // Exponential moving average
-    m_averageTime = m_averageAlpha * timeMark(threadId) + (1. - m_averageAlpha) * m_averageTime;
-    std::cout << "FaceFeatureStage average time: " << m_averageTime << std::endl;
+    // boxes are shared with other consumers, landmarks go to a new result
+    FaceResultsPtr faces_features = m_resultsPool.acquire();
+    faces_features->copyFacesFrom(rois);
+    faces_features->frame = frame;
 
-    if (faces_features.size() == 0) {
-        std::cout << "FaceFeaturesStage: " << "No face feature detected" << std::endl;
+    const double start = timeNow();
+    // Detect the faces features
+    const int num_faces = faces_features->numFaces;
+    if (!detector) {
+        // no face mesh compiled in with this name : boxes only
+    } else if (num_faces > 1 && m_primaryFaceOnly.load(std::memory_order_relaxed)) {
+        faces_features->swapFaces(0, faces_features->biggestFace());
+        faces_features->numFaces = 1;
+        (*detector)(frame.image, *faces_features);
+        faces_features->numFaces = num_faces;
     } else {
-        m_outFaceFeatures->push_back(faces_features);
+        (*detector)(frame.image, *faces_features);
     }
 
+    const double duration = timeNow() - start;
+    faces_features->setStageTiming(STAGE_FACE_FEATURES, duration, threadId);
 
+    // Exponential moving average
+    m_averageTime = m_averageAlpha * duration + (1. - m_averageAlpha) * m_averageTime;
 
-    if (m_outFaceFeatures->size() > MAX_OUT_QUEUE_SIZE)
-        m_outFaceFeatures->pop_front_no_wait();
+    return faces_features;
 }
 
 
-std::shared_ptr<IFaceFeatures> FaceFeaturesStage::getNextDetector(int threadId) {
-    std::lock_guard<std::mutex> guard(m_mutex);
+FaceFeaturesFactory FaceFeaturesStage::resolveFactory(const std::string& detectorName) {
+    const FaceFeaturesFactory factory = detectorFactory(detectorName);
+#ifdef RASPIDMS_ALL_FACE_MESHES
+    if (!factory)
+        return []() -> FaceMeshType* { return new FaceFeaturesEmpty(); };
+#else
+    if (!factory)
+        std::cerr << "FaceFeaturesStage: face mesh " << detectorName << " not compiled in" << std::endl;
+#endif
+    return factory;
+}
 
-    auto detectorIt = m_detectors.find(threadId);
-    if (detectorIt != m_detectors.end()) {
-        return detectorIt->second;
-    } else {
-        std::shared_ptr<IFaceFeatures> detector;
-        if (m_detectorName == "dlib_68")
-        {
-            detector.reset(new FaceFeaturesDlib(DLIB_68_FACE_LANDMARKS_PATH));
-            m_detectors.insert({threadId, detector});
-        }
-        else if (m_detectorName == "mediapipe")
-        {
-            detector.reset(new FaceFeaturesMediaPipe(MEDIAPIPE_FACE_LANDMARKS_PATH));
-            m_detectors.insert({threadId, detector});
-        }
-        else //do not insert detector if name unkown, but still return empty one
-        {
-            detector.reset(new FaceFeaturesEmpty());
+FaceFeaturesFactory FaceFeaturesStage::detectorFactory(const std::string& detectorName) {
+#if defined(RASPIDMS_ALL_FACE_MESHES) || defined(RASPIDMS_FACE_MESH_DLIB_68)
+    if (detectorName == "dlib_68")
+        return []() -> FaceMeshType* { return new FaceFeaturesDlib(DLIB_68_FACE_LANDMARKS_PATH); };
+#endif
+#if defined(RASPIDMS_ALL_FACE_MESHES) || defined(RASPIDMS_FACE_MESH_MEDIAPIPE)
+    if (detectorName == "mediapipe")
+        return []() -> FaceMeshType* { return new FaceFeaturesMediaPipe(MEDIAPIPE_FACE_LANDMARKS_PATH); };
+#endif
+
+    return nullptr;
+}
+
+std::shared_ptr<IFaceFeatures> FaceFeaturesStage::createDetector(const std::string& detectorName) {
+    const FaceFeaturesFactory factory = detectorFactory(detectorName);
+    return std::shared_ptr<IFaceFeatures>(factory ? factory() : nullptr);
+}
+
+ModelStartupTimes FaceFeaturesStage::preloadDetector(int threadId, const cv::Mat& warmupFrame,
+                                                      const FaceResults& rois, int warmupRuns) {
+    return m_detectors.preload(threadId, [&](FaceMeshType& detector) {
+        std::unique_ptr<FaceResults> faces(new FaceResults());
+        for (int run = 0; run < warmupRuns; ++run) {
+            faces->copyFacesFrom(rois);
+            detector(warmupFrame, *faces);
         }
+    });
+}
 
-        return detector;
-    }
+void FaceFeaturesStage::releaseDetector(int threadId) {
+    m_detectors.release(threadId);
 }
 
 double FaceFeaturesStage::averageTime() {
@@ -9,24 +9,41 @@
 #include <opencv2/dnn.hpp>
 #include <opencv2/core/utility.hpp>
 
-#include <unordered_map>
+#include <atomic>
+#include <memory>
 #include <vector>
 
+#include "SharedPool.h"
 #include "SharedQueue.h"
+#include "BuildConfig.h"
+#include "DetectorSlots.h"
 #include "FaceFeatures/IFaceFeatures.h"
 #include "DetectFaces/IDetectFaces.h"
+#include "Frame.h"
 #include "IStage.h"
 
 const std::string DLIB_68_FACE_LANDMARKS_PATH = "../res/shape_predictor_68_face_landmarks.dat";
 const std::string MEDIAPIPE_FACE_LANDMARKS_PATH = "../res/face_landmark.tflite";
 
+/**
+ * @brief FaceFeaturesFactory creates a face features detector, resolved from its name once (see FaceFeaturesStage::detectorFactory)
+ */
+typedef DetectorSlots<FaceMeshType>::Factory FaceFeaturesFactory;
+
+/**
+ * @brief The FaceFeaturesStage class detects the landmarks of the faces found by DetectFacesStage
+ *
+ * As DetectFacesStage, each thread id gets its own detector (see DetectorSlots) : finding it takes no lock.
+ * The factory is resolved at construction. In a single configuration build (see BuildConfig.h),
+ * only the face mesh compiled in is known.
+ */
 class FaceFeaturesStage : public IStage
 {
 public:
     FaceFeaturesStage(const std::string& detectorName,
-                      std::shared_ptr<SharedQueue<cv::Mat>> inFrames,
-                      std::shared_ptr<SharedQueue<PointsList>> regionOfInterests,
-                      std::shared_ptr<SharedQueue<PointsList>> outFaceFeatures);
+                      std::shared_ptr<SharedQueue<Frame>> inFrames,
+                      std::shared_ptr<SharedQueue<FaceResultsPtr>> regionOfInterests,
+                      std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures);
     FaceFeaturesStage(const FaceFeaturesStage&) = delete;
 
     /**
@@ -39,24 +56,75 @@ public:
      */
     virtual double averageTime() override;
 
-private:
     /**
-     * @brief getNextDetector
+     * @brief process detect the face features of frame in rois, without going through the queues
+     * @param frame
+     * @param rois faces to detect features of
      * @param threadId
-     * @return next detector, scheduled by schedNextDetector, and specialized by threadId (one threadId for one detector)
+     * @return the rois with their landmarks (possibly none)
      */
-    std::shared_ptr<IFaceFeatures> getNextDetector(int threadId);
+    FaceResultsPtr process(const Frame& frame, const FaceResults& rois, int threadId);
+
+    /**
+     * @brief createDetector
+     * @param detectorName dlib_68 or mediapipe
+     * @return a new face features detector, null if detectorName is unknown (or not compiled in)
+     */
+    static std::shared_ptr<IFaceFeatures> createDetector(const std::string& detectorName);
+
+    /**
+     * @brief detectorFactory
+     * @param detectorName see createDetector
+     * @return the factory of the face features detector, null if detectorName is unknown (or not compiled in)
+     */
+    static FaceFeaturesFactory detectorFactory(const std::string& detectorName);
+
+    /**
+     * @brief setPrimaryFaceOnly detect features of the biggest face only (put first), the others keep their boxes only
+     * @param primaryOnly
+     */
+    void setPrimaryFaceOnly(bool primaryOnly) { m_primaryFaceOnly.store(primaryOnly, std::memory_order_relaxed); }
+
+    /**
+     * @brief preloadDetector create the face features detector of a thread ahead of its first frame, and warm it up
+     * (nothing is done if the thread already has one, or if the detector is not compiled in)
+     * To be called before the thread with threadId runs the stage.
+     * @param threadId
+     * @param warmupFrame
+     * @param rois faces of warmupFrame
+     * @param warmupRuns
+     * @return the time it took to create the detector, and to run it warmupRuns times on warmupFrame
+     */
+    ModelStartupTimes preloadDetector(int threadId, const cv::Mat& warmupFrame, const FaceResults& rois, int warmupRuns);
+
+    const std::string& detectorName() const { return m_detectorName; }
+
+    /**
+     * @brief releaseDetector free the detector of a thread that will not run this stage anymore
+     * (a thread id given again gets a new detector)
+     * To be called from the thread with threadId, or while no thread runs the stage with threadId.
+     * @param threadId
+     */
+    void releaseDetector(int threadId);
+
+private:
+    /**
+     * @brief resolveFactory
+     * @param detectorName
+     * @return the factory of detectorName, or of the empty detector if unknown (none in a single configuration build)
+     */
+    static FaceFeaturesFactory resolveFactory(const std::string& detectorName);
 
     const std::string m_detectorName;
-    std::shared_ptr<SharedQueue<cv::Mat>> m_inFrames;
-    std::shared_ptr<SharedQueue<PointsList>> m_regionOfInterests;
-    std::shared_ptr<SharedQueue<PointsList>> m_outFaceFeatures;
-    PointsList m_lastValidRoi;
-    std::unordered_map<int /*threadId*/, std::shared_ptr<IFaceFeatures>> m_detectors;
-    std::mutex m_mutex;
+    std::shared_ptr<SharedQueue<Frame>> m_inFrames;
+    std::shared_ptr<SharedQueue<FaceResultsPtr>> m_regionOfInterests;
+    std::shared_ptr<SharedQueue<FaceResultsPtr>> m_outFaceFeatures;
+    FaceResultsPtr m_lastValidRoi;              // atomic_load / atomic_store
+    SharedPool<FaceResults> m_resultsPool;
+    DetectorSlots<FaceMeshType> m_detectors;
     double m_averageTime;
     double m_averageAlpha;
-
+    std::atomic<bool> m_primaryFaceOnly;
 };
 
 #endif // FACEFEATURESSTAGE_H
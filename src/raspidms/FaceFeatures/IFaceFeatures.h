@@ -2,6 +2,7 @@
 #define IFACEFEATURES_H
 
 #include "IStage.h"
+#include "PhaseTimings.h"
 
 #include <opencv2/core.hpp>
 #include <opencv2/objdetect.hpp>
@@ -19,22 +20,27 @@ class IFaceFeatures {
 public:
     IFaceFeatures(const std::string & path,
                  const std::string & secondPath = std::string())
-        : m_path(path), m_secondPath(secondPath) {}
+        : m_path(path), m_secondPath(secondPath), m_phaseTimings() {}
     virtual ~IFaceFeatures() {}
 
     /**
      * @brief operator ()
      * @param frame
-     * @return pair of
-     * - a vector of rectangles of faces (upleft, upright, w, h)
-     * - a double : time in second it took for computing
+     * @param faces as filled by IDetectFaces (boxes and keypoints if any).
+     * Landmarks are written in place, with hasLandmarks set for each face where they were found
      */
-    virtual PointsList operator()(const cv::Mat & frame,
-                                     std::vector<cv::Rect>& regionOfInterests) = 0;
+    virtual void operator()(const cv::Mat & frame, FaceResults& faces) = 0;
+
+    /**
+     * @brief phaseTimings
+     * @return preprocessing, inference and postprocessing times of the last call
+     */
+    const PhaseTimings& phaseTimings() const { return m_phaseTimings; }
 
 protected:
     const std::string m_path;
     const std::string m_secondPath;
+    PhaseTimings m_phaseTimings;
 };
 
 #endif // IFACEFEATURES_H
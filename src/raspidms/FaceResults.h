@@ -0,0 +1,278 @@
+#ifndef FACERESULTS_H
+#define FACERESULTS_H
+
+#include <opencv2/core/types.hpp>
+
+#include <algorithm>
+#include <memory>
+
+#include "Frame.h"
+
+const int MAX_FACES = 4;
+const int MAX_KEYPOINTS = 6;
+const int MAX_LANDMARKS = 468;
+
+/**
+ * @brief StageId indexes FaceResults::stageTimings, one per processing step a result goes through
+ */
+enum StageId {
+    STAGE_DETECT_FACES,
+    STAGE_FACE_FEATURES,
+    STAGE_LANDMARKS_FILTER,
+    STAGE_DRIVER_STATE,
+    STAGE_HEAD_POSE,
+    STAGE_PUPILS,
+    STAGE_ALERTS,
+    NUM_STAGES
+};
+
+inline const char* stageName(StageId stage) {
+    switch (stage) {
+    case STAGE_DETECT_FACES: return "detect_faces";
+    case STAGE_FACE_FEATURES: return "face_features";
+    case STAGE_LANDMARKS_FILTER: return "landmarks_filter";
+    case STAGE_DRIVER_STATE: return "driver_state";
+    case STAGE_HEAD_POSE: return "head_pose";
+    case STAGE_PUPILS: return "pupils";
+    case STAGE_ALERTS: return "alerts";
+    case NUM_STAGES: break;
+    }
+    return "unknown";
+}
+
+/**
+ * @brief StageTiming is the time a stage took on a result, and the id of the thread that ran it
+ * threadId is -1 if the stage did not run on this result
+ */
+struct StageTiming {
+    float duration;    // seconds
+    int threadId;
+};
+
+/**
+ * @brief DriverState holds the drowsiness indicators of the driver (the biggest face with landmarks)
+ * Filled by DriverStateStage, valid is false if there was no driver face in the results
+ */
+struct DriverState {
+    bool valid;
+    int face;                    // index of the driver face
+    float eyeAspectRatio;        // mean of both eyes, lower when eyes close
+    float mouthAspectRatio;      // higher when mouth opens
+    bool eyesClosed;
+    double eyesClosedDuration;   // seconds since eyes closed, 0 if open
+    bool yawning;
+    float perclos;               // fraction of time eyes were closed over the PERCLOS window
+    float yawnsPerMinute;        // over the yawn window
+};
+
+/**
+ * @brief FaceResults is the result type passed between stages
+ * It has a fixed capacity and a flat layout (structure of arrays), so that it never allocates
+ * once created, and can be recycled through a SharedPool.
+ * Faces above MAX_FACES are dropped.
+ *
+ * For each face :
+ * - a bounding box {left, top, right, bottom} and a score, filled by IDetectFaces
+ *   detectionTimestamp is the capture timestamp of the frame the boxes were detected on
+ *   (older than frame.timestamp when boxes of a previous detection are reused)
+ * - numKeypoints keypoints, filled by IDetectFaces when available
+ *   (mediapipe order : right eye, left eye, nose tip, mouth center, right ear tragion, left ear tragion)
+ * - numLandmarks landmarks, filled by IFaceFeatures (only when hasLandmarks[face] is true)
+ *   z is the depth relative to the face center, in pixels, when given by the model, 0 otherwise
+ * - head pose angles in degrees, filled by HeadPoseStage (only when hasHeadPose[face] is true)
+ *   yaw positive towards image right, pitch positive downwards, roll positive clockwise
+ * - pupil centers {image left eye, image right eye}, filled by PupilsStage (only when hasPupils[face] is true)
+ *
+ * And for the driver, driverState filled by DriverStateStage
+ *
+ * stageTimings are filled by each stage as the result goes through it (detection timing comes with the boxes)
+ *
+ * frame is the one the results were computed on (its image is shared, not copied)
+ *
+ * Once pushed to a SharedQueue read by several consumers, results must be considered immutable.
+ */
+struct FaceResults {
+    Frame frame;
+
+    int numFaces;
+    int numKeypoints;
+    int numLandmarks;
+
+    double detectionTimestamp;
+
+    float boxLeft[MAX_FACES];
+    float boxTop[MAX_FACES];
+    float boxRight[MAX_FACES];
+    float boxBottom[MAX_FACES];
+    float scores[MAX_FACES];
+
+    float keypointsX[MAX_FACES][MAX_KEYPOINTS];
+    float keypointsY[MAX_FACES][MAX_KEYPOINTS];
+
+    bool hasLandmarks[MAX_FACES];
+    float landmarksX[MAX_FACES][MAX_LANDMARKS];
+    float landmarksY[MAX_FACES][MAX_LANDMARKS];
+    float landmarksZ[MAX_FACES][MAX_LANDMARKS];
+
+    bool hasHeadPose[MAX_FACES];
+    float headYaw[MAX_FACES];
+    float headPitch[MAX_FACES];
+    float headRoll[MAX_FACES];
+
+    bool hasPupils[MAX_FACES];
+    float pupilsX[MAX_FACES][2];
+    float pupilsY[MAX_FACES][2];
+
+    DriverState driverState;
+
+    StageTiming stageTimings[NUM_STAGES];
+
+    FaceResults() { clear(); }
+
+    void clear() {
+        frame = Frame();
+        numFaces = 0;
+        numKeypoints = 0;
+        numLandmarks = 0;
+        detectionTimestamp = 0.;
+        driverState.valid = false;
+        for (int stage = 0; stage < NUM_STAGES; ++stage)
+            stageTimings[stage] = {0.f, -1};
+    }
+
+    /**
+     * @brief addFace
+     * @param topLeft
+     * @param bottomRight
+     * @param score
+     * @return index of the new face, -1 if MAX_FACES is reached
+     */
+    int addFace(const cv::Point2f& topLeft, const cv::Point2f& bottomRight, float score = 1.f) {
+        if (numFaces >= MAX_FACES)
+            return -1;
+
+        const int face = numFaces++;
+        boxLeft[face] = topLeft.x;
+        boxTop[face] = topLeft.y;
+        boxRight[face] = bottomRight.x;
+        boxBottom[face] = bottomRight.y;
+        scores[face] = score;
+        hasLandmarks[face] = false;
+        hasHeadPose[face] = false;
+        hasPupils[face] = false;
+        return face;
+    }
+
+    /**
+     * @brief copyFacesFrom copy boxes, scores and keypoints of other (with their detection timestamp and timing),
+     * but not its frame nor its landmarks
+     * @param other
+     */
+    void copyFacesFrom(const FaceResults& other) {
+        clear();
+        detectionTimestamp = other.detectionTimestamp;
+        stageTimings[STAGE_DETECT_FACES] = other.stageTimings[STAGE_DETECT_FACES];
+        numKeypoints = other.numKeypoints;
+        for (int face = 0; face < other.numFaces; ++face) {
+            addFace(other.topLeft(face), other.bottomRight(face), other.scores[face]);
+            for (int k = 0; k < numKeypoints; ++k) {
+                keypointsX[face][k] = other.keypointsX[face][k];
+                keypointsY[face][k] = other.keypointsY[face][k];
+            }
+        }
+    }
+
+    /**
+     * @brief scaleFaces scale boxes and keypoints (detections on a resized frame, back to the frame)
+     * @param factor
+     */
+    void scaleFaces(float factor) {
+        for (int face = 0; face < numFaces; ++face) {
+            boxLeft[face] *= factor;
+            boxTop[face] *= factor;
+            boxRight[face] *= factor;
+            boxBottom[face] *= factor;
+            for (int k = 0; k < numKeypoints; ++k) {
+                keypointsX[face][k] *= factor;
+                keypointsY[face][k] *= factor;
+            }
+        }
+    }
+
+    /**
+     * @brief biggestFace
+     * @return index of the face with the biggest box, -1 if there is no face
+     */
+    int biggestFace() const {
+        int biggest = -1;
+        float biggest_area = -1.f;
+        for (int face = 0; face < numFaces; ++face) {
+            const float area = box(face).area();
+            if (area > biggest_area) {
+                biggest = face;
+                biggest_area = area;
+            }
+        }
+        return biggest;
+    }
+
+    /**
+     * @brief swapFaces swap boxes, scores, keypoints and flags of two faces, before landmarks are filled
+     * @param a
+     * @param b
+     */
+    void swapFaces(int a, int b) {
+        std::swap(boxLeft[a], boxLeft[b]);
+        std::swap(boxTop[a], boxTop[b]);
+        std::swap(boxRight[a], boxRight[b]);
+        std::swap(boxBottom[a], boxBottom[b]);
+        std::swap(scores[a], scores[b]);
+        std::swap(keypointsX[a], keypointsX[b]);
+        std::swap(keypointsY[a], keypointsY[b]);
+        std::swap(hasLandmarks[a], hasLandmarks[b]);
+        std::swap(hasHeadPose[a], hasHeadPose[b]);
+        std::swap(hasPupils[a], hasPupils[b]);
+    }
+
+    cv::Point2f topLeft(int face) const { return cv::Point2f(boxLeft[face], boxTop[face]); }
+    cv::Point2f bottomRight(int face) const { return cv::Point2f(boxRight[face], boxBottom[face]); }
+    cv::Rect2f box(int face) const { return cv::Rect2f(topLeft(face), bottomRight(face)); }
+
+    cv::Point2f keypoint(int face, int k) const { return cv::Point2f(keypointsX[face][k], keypointsY[face][k]); }
+    void setKeypoint(int face, int k, const cv::Point2f& p) {
+        keypointsX[face][k] = p.x;
+        keypointsY[face][k] = p.y;
+    }
+
+    cv::Point2f landmark(int face, int i) const { return cv::Point2f(landmarksX[face][i], landmarksY[face][i]); }
+    void setLandmark(int face, int i, const cv::Point2f& p, float z = 0.f) {
+        landmarksX[face][i] = p.x;
+        landmarksY[face][i] = p.y;
+        landmarksZ[face][i] = z;
+    }
+
+    void setStageTiming(StageId stage, double duration, int threadId) {
+        stageTimings[stage] = {static_cast<float>(duration), threadId};
+    }
+
+    cv::Point2f pupil(int face, int eye) const { return cv::Point2f(pupilsX[face][eye], pupilsY[face][eye]); }
+    void setPupil(int face, int eye, const cv::Point2f& p) {
+        pupilsX[face][eye] = p.x;
+        pupilsY[face][eye] = p.y;
+    }
+
+    /**
+     * @brief numFacesWithLandmarks
+     * @return the number of faces for which landmarks were found
+     */
+    int numFacesWithLandmarks() const {
+        int n = 0;
+        for (int face = 0; face < numFaces; ++face)
+            n += hasLandmarks[face] ? 1 : 0;
+        return n;
+    }
+};
+
+typedef std::shared_ptr<FaceResults> FaceResultsPtr;
+
+#endif // FACERESULTS_H
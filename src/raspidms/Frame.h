@@ -0,0 +1,21 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <opencv2/core.hpp>
+
+/**
+ * @brief Frame is a captured image, with its sequence id and its capture timestamp
+ * Timestamp is in seconds, in the time base of timeNow() (see Utils.h)
+ * Copying a Frame does not copy the image data
+ */
+struct Frame {
+    cv::Mat image;
+    long id;
+    double timestamp;
+
+    Frame() : image(), id(-1), timestamp(0.) {}
+    Frame(const cv::Mat& image, long id, double timestamp)
+        : image(image), id(id), timestamp(timestamp) {}
+};
+
+#endif // FRAME_H
@@ -0,0 +1,160 @@
+#include "Gaze/PupilLocator.h"
+
+#include "Simd.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// eye patch width (multiple of 4), the height follows the region aspect ratio
+const int PATCH_WIDTH = 32;
+const int MIN_PATCH_HEIGHT = 8;
+const int MAX_PATCH_HEIGHT = 32;
+
+// regions smaller than this (in pixels) are not worth it
+const int MIN_ROI_WIDTH = 8;
+
+// gradients weaker than mean + GRADIENT_THRESHOLD * std dev are ignored
+const float GRADIENT_THRESHOLD = 0.3f;
+
+static const float kLaneOffsets[4] = {0.f, 1.f, 2.f, 3.f};
+
+PupilLocator::PupilLocator()
+    : m_resized(),
+      m_patch(),
+      m_blurred(),
+      m_gradX(),
+      m_gradY(),
+      m_posX(),
+      m_posY(),
+      m_magnitude(),
+      m_objective(),
+      m_stride(PATCH_WIDTH)
+{
+    const size_t capacity = PATCH_WIDTH * MAX_PATCH_HEIGHT;
+    m_gradX.reserve(capacity);
+    m_gradY.reserve(capacity);
+    m_posX.reserve(capacity);
+    m_posY.reserve(capacity);
+    m_magnitude.resize(capacity);
+    m_objective.resize(capacity);
+}
+
+bool PupilLocator::operator()(const cv::Mat& frame, const cv::Rect& eyeRoi, cv::Point2f& pupil) {
+    if (eyeRoi.width < MIN_ROI_WIDTH || eyeRoi.height <= 0)
+        return false;
+
+    const int height = std::max(MIN_PATCH_HEIGHT, std::min(MAX_PATCH_HEIGHT,
+                                static_cast<int>(std::lround(PATCH_WIDTH * eyeRoi.height / static_cast<double>(eyeRoi.width)))));
+
+    // scale down the color region first : color conversion and blur only run on the small patch
+    cv::resize(frame(eyeRoi), m_resized, cv::Size(PATCH_WIDTH, height), 0, 0, cv::INTER_AREA);
+    cv::cvtColor(m_resized, m_patch, cv::COLOR_BGR2GRAY);
+    cv::GaussianBlur(m_patch, m_blurred, cv::Size(5, 5), 0);
+
+    const int n_gradients = computeGradients();
+    if (n_gradients == 0)
+        return false;
+
+    computeObjective(n_gradients);
+
+    // darker centers are more likely, the pupil being the darkest part of the eye
+    float best = -1.f;
+    int best_x = 0;
+    int best_y = 0;
+    for (int y = 1; y < height - 1; ++y) {
+        const uchar* blurred = m_blurred.ptr<uchar>(y);
+        const float* objective = &m_objective[y * m_stride];
+        for (int x = 1; x < PATCH_WIDTH - 1; ++x) {
+            const float value = objective[x] * (255 - blurred[x]);
+            if (value > best) {
+                best = value;
+                best_x = x;
+                best_y = y;
+            }
+        }
+    }
+
+    pupil.x = eyeRoi.x + (best_x + 0.5f) * eyeRoi.width / static_cast<float>(PATCH_WIDTH);
+    pupil.y = eyeRoi.y + (best_y + 0.5f) * eyeRoi.height / static_cast<float>(height);
+    return true;
+}
+
+int PupilLocator::computeGradients() {
+    const int width = m_patch.cols;
+    const int height = m_patch.rows;
+
+    // central differences, borders are left out
+    double sum = 0.;
+    double sum_sq = 0.;
+    int n = 0;
+    for (int y = 1; y < height - 1; ++y) {
+        const uchar* up = m_patch.ptr<uchar>(y - 1);
+        const uchar* row = m_patch.ptr<uchar>(y);
+        const uchar* down = m_patch.ptr<uchar>(y + 1);
+        float* magnitude = &m_magnitude[y * width];
+        for (int x = 1; x < width - 1; ++x) {
+            const float gx = 0.5f * (row[x + 1] - row[x - 1]);
+            const float gy = 0.5f * (down[x] - up[x]);
+            magnitude[x] = std::sqrt(gx * gx + gy * gy);
+            sum += magnitude[x];
+            sum_sq += magnitude[x] * magnitude[x];
+            ++n;
+        }
+    }
+
+    const double mean = sum / n;
+    const double std_dev = std::sqrt(std::max(0., sum_sq / n - mean * mean));
+    const float threshold = static_cast<float>(mean + GRADIENT_THRESHOLD * std_dev);
+
+    m_gradX.clear();
+    m_gradY.clear();
+    m_posX.clear();
+    m_posY.clear();
+    for (int y = 1; y < height - 1; ++y) {
+        const uchar* up = m_patch.ptr<uchar>(y - 1);
+        const uchar* row = m_patch.ptr<uchar>(y);
+        const uchar* down = m_patch.ptr<uchar>(y + 1);
+        const float* magnitude = &m_magnitude[y * width];
+        for (int x = 1; x < width - 1; ++x) {
+            if (magnitude[x] <= threshold || magnitude[x] <= 0.f)
+                continue;
+            m_gradX.push_back(0.5f * (row[x + 1] - row[x - 1]) / magnitude[x]);
+            m_gradY.push_back(0.5f * (down[x] - up[x]) / magnitude[x]);
+            m_posX.push_back(static_cast<float>(x));
+            m_posY.push_back(static_cast<float>(y));
+        }
+    }
+
+    return static_cast<int>(m_gradX.size());
+}
+
+void PupilLocator::computeObjective(int nGradients) {
+    const int height = m_patch.rows;
+    m_stride = (PATCH_WIDTH + 3) & ~3;
+
+    const float4 zero = set4(0.f);
+    const float4 epsilon = set4(1e-3f);
+    const float4 offsets = load4(kLaneOffsets);
+
+    // sum over gradients of max(0, d.g)^2 / |d|^2, with d the displacement from the candidate center
+    // (the squared normalized dot product of the Timm & Barth objective, without any square root)
+    // 4 candidate centers of a row at a time
+    for (int y = 0; y < height; ++y) {
+        const float4 cy = set4(static_cast<float>(y));
+        for (int x = 0; x < m_stride; x += 4) {
+            const float4 cx = add4(set4(static_cast<float>(x)), offsets);
+            float4 acc = zero;
+            for (int i = 0; i < nGradients; ++i) {
+                const float4 dx = sub4(set4(m_posX[i]), cx);
+                const float4 dy = sub4(set4(m_posY[i]), cy);
+                float4 dot = madd4(mul4(dx, set4(m_gradX[i])), dy, set4(m_gradY[i]));
+                dot = max4(dot, zero);
+                const float4 norm = madd4(madd4(epsilon, dx, dx), dy, dy);
+                acc = add4(acc, div4(mul4(dot, dot), norm));
+            }
+            store4(&m_objective[y * m_stride + x], acc);
+        }
+    }
+}
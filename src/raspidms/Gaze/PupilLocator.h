@@ -0,0 +1,59 @@
+#ifndef PUPILLOCATOR_H
+#define PUPILLOCATOR_H
+
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+/**
+ * @brief The PupilLocator class finds the pupil center in an eye region with the means of gradients method
+ * (Timm & Barth, "Accurate eye centre localisation by means of gradients", 2011) :
+ * the center is the point the most image gradients point away from, weighted by darkness.
+ * The region is first scaled down to a small fixed size patch, so that the cost does not depend on the face size.
+ * Only the region is read from the frame.
+ * Not thread safe : buffers are reused from one call to the next, use one locator per thread.
+ */
+class PupilLocator
+{
+public:
+    PupilLocator();
+
+    /**
+     * @brief operator() locate the pupil
+     * @param frame BGR frame
+     * @param eyeRoi eye region in frame, must be inside frame
+     * @param pupil pupil center, in frame coordinates
+     * @return false if the region is too small or uniform
+     */
+    bool operator()(const cv::Mat& frame, const cv::Rect& eyeRoi, cv::Point2f& pupil);
+
+private:
+    /**
+     * @brief computeGradients fill the strong normalized gradients of m_patch
+     * @return the number of strong gradients
+     */
+    int computeGradients();
+
+    /**
+     * @brief computeObjective fill m_objective for every candidate center of the patch
+     * @param nGradients
+     */
+    void computeObjective(int nGradients);
+
+    cv::Mat m_resized;
+    cv::Mat m_patch;
+    cv::Mat m_blurred;
+
+    // strong gradients : position and normalized direction
+    std::vector<float> m_gradX;
+    std::vector<float> m_gradY;
+    std::vector<float> m_posX;
+    std::vector<float> m_posY;
+    std::vector<float> m_magnitude;
+
+    // candidate centers, rows padded to a multiple of 4
+    std::vector<float> m_objective;
+    int m_stride;
+};
+
+#endif // PUPILLOCATOR_H
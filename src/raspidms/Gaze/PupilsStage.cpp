@@ -0,0 +1,83 @@
+#include "Gaze/PupilsStage.h"
+
+#include "DriverState/LandmarksIndexMap.h"
+#include <algorithm>
+
+const double INITIAL_AVERAGE_TIME = 0.0005;
+
+// eye region around the eye contour : horizontal margin, and minimal height, in eye width ratio
+// (eyelid landmarks are close to each other when the eye is half closed, the iris is not)
+const float EYE_ROI_MARGIN = 0.1f;
+const float EYE_ROI_MIN_HEIGHT = 0.5f;
+
+static cv::Rect eyeRoi(const FaceResults& faces, int face, const int (&eye)[6], const cv::Size& frameSize) {
+    float left = faces.landmarksX[face][eye[0]];
+    float right = left;
+    float top = faces.landmarksY[face][eye[0]];
+    float bottom = top;
+    for (int i = 1; i < 6; ++i) {
+        left = std::min(left, faces.landmarksX[face][eye[i]]);
+        right = std::max(right, faces.landmarksX[face][eye[i]]);
+        top = std::min(top, faces.landmarksY[face][eye[i]]);
+        bottom = std::max(bottom, faces.landmarksY[face][eye[i]]);
+    }
+
+    const float width = right - left;
+    const float margin = EYE_ROI_MARGIN * width;
+    const float height = std::max(bottom - top, EYE_ROI_MIN_HEIGHT * width);
+    const float center_y = 0.5f * (top + bottom);
+
+    cv::Rect roi(cv::Point(static_cast<int>(left - margin), static_cast<int>(center_y - 0.5f * height)),
+                 cv::Point(static_cast<int>(right + margin), static_cast<int>(center_y + 0.5f * height)));
+    return roi & cv::Rect(cv::Point(0, 0), frameSize);
+}
+
+PupilsStage::PupilsStage(std::shared_ptr<SharedQueue<FaceResultsPtr>> inFaceFeatures,
+                         std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures)
+    : ResultsStage("pupils", STAGE_PUPILS, INITIAL_AVERAGE_TIME, true, inFaceFeatures, outFaceFeatures),
+      m_locators()
+{
+
+}
+
+void PupilsStage::process(FaceResults& faces) {
+    const LandmarksIndexMap* indexMap = landmarksIndexMap(faces.numLandmarks);
+    const cv::Mat& image = faces.frame.image;
+    if (!indexMap || image.empty())
+        return;
+
+    // eye regions of all faces, in the pupils order : image left eye, image right eye
+    cv::Rect rois[MAX_FACES * 2];
+    int eye_faces[MAX_FACES * 2];
+    int n_eyes = 0;
+    for (int face = 0; face < faces.numFaces; ++face) {
+        faces.hasPupils[face] = false;
+        if (!faces.hasLandmarks[face])
+            continue;
+        eye_faces[n_eyes] = face;
+        rois[n_eyes++] = eyeRoi(faces, face, indexMap->rightEye, image.size());
+        eye_faces[n_eyes] = face;
+        rois[n_eyes++] = eyeRoi(faces, face, indexMap->leftEye, image.size());
+    }
+    if (n_eyes == 0)
+        return;
+
+    cv::Point2f pupils[MAX_FACES * 2];
+    bool found[MAX_FACES * 2];
+
+    // OpenCV workers rather than the Scheduler pool : this stage already runs on one of its threads,
+    // and waiting there for tasks queued behind other stages would stall the pipeline
+    cv::parallel_for_(cv::Range(0, n_eyes), [&](const cv::Range& range) {
+        for (int eye = range.start; eye < range.end; ++eye)
+            found[eye] = m_locators[eye](image, rois[eye], pupils[eye]);
+    });
+
+    for (int eye = 0; eye < n_eyes; eye += 2) {
+        const int face = eye_faces[eye];
+        if (!found[eye] || !found[eye + 1])
+            continue;
+        faces.hasPupils[face] = true;
+        faces.setPupil(face, 0, pupils[eye]);
+        faces.setPupil(face, 1, pupils[eye + 1]);
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef PUPILSSTAGE_H
+#define PUPILSSTAGE_H
+
+#include <memory>
+
+#include "Gaze/PupilLocator.h"
+#include "ResultsStage.h"
+
+/**
+ * @brief The PupilsStage class locates the pupils of each face with landmarks, for gaze estimation
+ * Eye regions are cropped around the eye contour landmarks (see LandmarksIndexMap),
+ * and all eyes of the results are processed in parallel by a PupilLocator each.
+ */
+class PupilsStage : public ResultsStage
+{
+public:
+    PupilsStage(std::shared_ptr<SharedQueue<FaceResultsPtr>> inFaceFeatures,
+                std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures);
+    PupilsStage(const PupilsStage&) = delete;
+
+protected:
+    /**
+     * override void ResultsStage::process(FaceResults&);
+     * fill pupils of all faces with landmarks in faces
+     */
+    virtual void process(FaceResults& faces) override;
+
+private:
+    // one per eye, so that all eyes can be processed at once (process is serialized)
+    PupilLocator m_locators[MAX_FACES * 2];
+};
+
+#endif // PUPILSSTAGE_H
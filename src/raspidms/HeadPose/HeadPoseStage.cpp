@@ -0,0 +1,153 @@
+#include "HeadPose/HeadPoseStage.h"
+
+#include "DriverState/LandmarksIndexMap.h"
+#include "Utils.h"
+
+#include <opencv2/calib3d.hpp>
+
+#include <cmath>
+
+const double INITIAL_AVERAGE_TIME = 0.0002;
+
+// minimal overlap for a face to be considered the same as the previous one
+const float TRACK_IOU_THRESHOLD = 0.3f;
+
+// the pose is not solved again if no pose landmark moved more than this (in face width ratio)
+const float MIN_MOTION = 0.005f;
+
+static const float RAD_TO_DEG = 57.2957795131f;
+
+// Canonical 3D face (arbitrary unit ~ 0.1 mm), same order as LandmarksIndexMap::pose
+// axes like the camera ones (x right, y down, z forward) so that a face looking at the camera has no rotation
+static const cv::Point3f kCanonicalFace[6] = {
+    {   0.f,    0.f,   0.f}, // nose tip
+    {   0.f,  330.f,  65.f}, // chin
+    {-225.f, -170.f, 135.f}, // image left eye outer corner
+    { 225.f, -170.f, 135.f}, // image right eye outer corner
+    {-150.f,  150.f, 125.f}, // image left mouth corner
+    { 150.f,  150.f, 125.f}, // image right mouth corner
+};
+
+HeadPoseStage::HeadPoseStage(std::shared_ptr<SharedQueue<FaceResultsPtr>> inFaceFeatures,
+                             std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures)
+    : ResultsStage("head_pose", STAGE_HEAD_POSE, INITIAL_AVERAGE_TIME, true, inFaceFeatures, outFaceFeatures),
+      m_tracks(),
+      m_lastTimestamp(0.),
+      m_frameSize(),
+      m_cameraMatrix(),
+      m_distCoeffs(cv::Mat::zeros(4, 1, CV_64F)),
+      m_modelPoints(kCanonicalFace, kCanonicalFace + 6),
+      m_imagePoints(6)
+{
+    for (auto& track : m_tracks) {
+        track.active = false;
+        track.rvec = cv::Mat::zeros(3, 1, CV_64F);
+        track.tvec = cv::Mat::zeros(3, 1, CV_64F);
+    }
+}
+
+void HeadPoseStage::process(FaceResults& faces) {
+    const LandmarksIndexMap* indexMap = landmarksIndexMap(faces.numLandmarks);
+    if (!indexMap)
+        return;
+
+    // results computed in parallel may come out of order, the older ones are left without pose
+    if (faces.frame.timestamp < m_lastTimestamp)
+        return;
+    m_lastTimestamp = faces.frame.timestamp;
+
+    // camera matrix is only rebuilt when the frame size changes
+    // no calibration : focal length ~ frame width, principal point at the center
+    const cv::Size frame_size = faces.frame.image.size();
+    if (frame_size != m_frameSize) {
+        m_frameSize = frame_size;
+        const double focal = frame_size.width;
+        m_cameraMatrix = cv::Mat::eye(3, 3, CV_64F);
+        m_cameraMatrix.at<double>(0, 0) = focal;
+        m_cameraMatrix.at<double>(1, 1) = focal;
+        m_cameraMatrix.at<double>(0, 2) = frame_size.width / 2.;
+        m_cameraMatrix.at<double>(1, 2) = frame_size.height / 2.;
+        for (auto& track : m_tracks)
+            track.active = false;
+    }
+
+    bool matched[MAX_FACES] = {false};
+    cv::Rect2f track_boxes[MAX_FACES];
+    bool available[MAX_FACES];
+    for (int t = 0; t < MAX_FACES; ++t)
+        track_boxes[t] = m_tracks[t].box;
+
+    for (int face = 0; face < faces.numFaces; ++face) {
+        if (!faces.hasLandmarks[face])
+            continue;
+
+        const cv::Rect2f box = faces.box(face);
+        for (int t = 0; t < MAX_FACES; ++t)
+            available[t] = m_tracks[t].active && !matched[t];
+        int best = bestIouMatch(track_boxes, available, MAX_FACES, box, TRACK_IOU_THRESHOLD);
+
+        bool warm = best >= 0;
+        if (!warm) {
+            for (int t = 0; t < MAX_FACES && best < 0; ++t) {
+                if (!m_tracks[t].active && !matched[t])
+                    best = t;
+            }
+        }
+        if (best < 0)
+            continue;
+
+        Track& track = m_tracks[best];
+        matched[best] = true;
+
+        float max_motion = 0.f;
+        for (int i = 0; i < 6; ++i) {
+            m_imagePoints[i] = faces.landmark(face, indexMap->pose[i]);
+            const cv::Point2f motion = m_imagePoints[i] - track.points[i];
+            max_motion = std::max(max_motion, std::max(std::fabs(motion.x), std::fabs(motion.y)));
+        }
+
+        const bool still = warm && max_motion < MIN_MOTION * box.width;
+        if (!still) {
+            if (!solve(track)) {
+                track.active = false;
+                continue;
+            }
+            std::copy(m_imagePoints.begin(), m_imagePoints.end(), track.points);
+        }
+
+        track.box = box;
+        track.active = true;
+        faces.hasHeadPose[face] = true;
+        faces.headYaw[face] = track.yaw;
+        faces.headPitch[face] = track.pitch;
+        faces.headRoll[face] = track.roll;
+    }
+
+    // faces that were not seen in these results are lost
+    for (int t = 0; t < MAX_FACES; ++t) {
+        if (!matched[t])
+            m_tracks[t].active = false;
+    }
+}
+
+bool HeadPoseStage::solve(Track& track) {
+    // warm start from the previous pose of the same face
+    if (!cv::solvePnP(m_modelPoints, m_imagePoints, m_cameraMatrix, m_distCoeffs,
+                      track.rvec, track.tvec, track.active, cv::SOLVEPNP_ITERATIVE))
+        return false;
+
+    // face must be in front of the camera
+    if (track.tvec.at<double>(2) <= 0.)
+        return false;
+
+    cv::Mat r;
+    cv::Rodrigues(track.rvec, r);
+
+    // r = Rz(roll) * Ry(-yaw) * Rx(pitch) : a positive rotation around y turns the nose towards image left,
+    // yaw is positive towards image right (see FaceResults)
+    const double sin_yaw = std::max(-1., std::min(1., r.at<double>(2, 0)));
+    track.pitch = static_cast<float>(std::atan2(r.at<double>(2, 1), r.at<double>(2, 2))) * RAD_TO_DEG;
+    track.yaw = static_cast<float>(std::asin(sin_yaw)) * RAD_TO_DEG;
+    track.roll = static_cast<float>(std::atan2(r.at<double>(1, 0), r.at<double>(0, 0))) * RAD_TO_DEG;
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef HEADPOSESTAGE_H
+#define HEADPOSESTAGE_H
+
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "ResultsStage.h"
+
+/**
+ * @brief The HeadPoseStage class estimates yaw, pitch and roll of each face with landmarks
+ * 6 landmarks (see LandmarksIndexMap::pose) are matched against a canonical 3D face with iterative PnP.
+ * Each face is followed from one result to the next (by box overlap) : its previous pose is the initial
+ * guess of the solver, and the solve is skipped when its landmarks barely moved.
+ */
+class HeadPoseStage : public ResultsStage
+{
+public:
+    HeadPoseStage(std::shared_ptr<SharedQueue<FaceResultsPtr>> inFaceFeatures,
+                  std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures);
+    HeadPoseStage(const HeadPoseStage&) = delete;
+
+protected:
+    /**
+     * override void ResultsStage::process(FaceResults&);
+     * fill head pose of all faces with landmarks in faces
+     */
+    virtual void process(FaceResults& faces) override;
+
+private:
+    struct Track {
+        cv::Rect2f box;
+        bool active;
+        cv::Mat rvec;
+        cv::Mat tvec;
+        cv::Point2f points[6];
+        float yaw;
+        float pitch;
+        float roll;
+    };
+
+    /**
+     * @brief solve run PnP for track against m_imagePoints
+     * @param track
+     * @return false if no pose was found
+     */
+    bool solve(Track& track);
+
+    // state over time, shared by all threads (process is serialized)
+    Track m_tracks[MAX_FACES];
+    double m_lastTimestamp;
+    cv::Size m_frameSize;
+    cv::Mat m_cameraMatrix;
+    cv::Mat m_distCoeffs;
+    std::vector<cv::Point3f> m_modelPoints;
+    std::vector<cv::Point2f> m_imagePoints;
+};
+
+#endif // HEADPOSESTAGE_H
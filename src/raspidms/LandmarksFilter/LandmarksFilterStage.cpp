@@ -0,0 +1,100 @@
+#include "LandmarksFilter/LandmarksFilterStage.h"
+
+#include "Utils.h"
+
+const double INITIAL_AVERAGE_TIME = 0.0001;
+
+// minimal overlap for a face to be considered the same as the previous one
+const float TRACK_IOU_THRESHOLD = 0.3f;
+
+LandmarksFilterStage::LandmarksFilterStage(std::shared_ptr<SharedQueue<FaceResultsPtr>> inFaceFeatures,
+                                           std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures)
+    : ResultsStage("landmarks_filter", STAGE_LANDMARKS_FILTER, INITIAL_AVERAGE_TIME, true,
+                   inFaceFeatures, outFaceFeatures),
+      m_tracks(),
+      m_lastTimestamp(0.)
+{
+    for (auto& track : m_tracks)
+        track.active = false;
+}
+
+void LandmarksFilterStage::process(FaceResults& faces) {
+    // results computed in parallel may come out of order, or again for the same frame :
+    // older ones get the last filtered landmarks, rather than raw ones alternating with them downstream
+    if (faces.frame.timestamp < m_lastTimestamp) {
+        holdFiltered(faces);
+        return;
+    }
+    m_lastTimestamp = faces.frame.timestamp;
+
+    bool matched[MAX_FACES] = {false};
+    cv::Rect2f track_boxes[MAX_FACES];
+    bool available[MAX_FACES];
+    for (int t = 0; t < MAX_FACES; ++t)
+        track_boxes[t] = m_tracks[t].box;
+
+    for (int face = 0; face < faces.numFaces; ++face) {
+        if (!faces.hasLandmarks[face])
+            continue;
+
+        const cv::Rect2f box = faces.box(face);
+
+        // follow the active track overlapping the most with this face
+        for (int t = 0; t < MAX_FACES; ++t)
+            available[t] = m_tracks[t].active && !matched[t];
+        int best = bestIouMatch(track_boxes, available, MAX_FACES, box, TRACK_IOU_THRESHOLD);
+
+        // or start a new one
+        if (best < 0) {
+            for (int t = 0; t < MAX_FACES; ++t) {
+                if (!m_tracks[t].active && !matched[t]) {
+                    best = t;
+                    m_tracks[t].filter.reset();
+                    break;
+                }
+            }
+        }
+
+        if (best < 0)
+            continue;
+
+        Track& track = m_tracks[best];
+        const float value_scale = box.width > 0.f ? 1.f / box.width : 1.f;
+        if (track.filter(faces.landmarksX[face], faces.landmarksY[face], faces.numLandmarks,
+                         faces.frame.timestamp, value_scale)) {
+            track.box = box;
+        }
+        track.active = true;
+        matched[best] = true;
+    }
+
+    // faces that were not seen in these results are lost
+    for (int t = 0; t < MAX_FACES; ++t) {
+        if (!matched[t])
+            m_tracks[t].active = false;
+    }
+}
+
+void LandmarksFilterStage::holdFiltered(FaceResults& faces) {
+    bool matched[MAX_FACES] = {false};
+    cv::Rect2f track_boxes[MAX_FACES];
+    bool available[MAX_FACES];
+    for (int t = 0; t < MAX_FACES; ++t)
+        track_boxes[t] = m_tracks[t].box;
+
+    for (int face = 0; face < faces.numFaces; ++face) {
+        if (!faces.hasLandmarks[face])
+            continue;
+
+        for (int t = 0; t < MAX_FACES; ++t)
+            available[t] = m_tracks[t].active && !matched[t];
+        const int best = bestIouMatch(track_boxes, available, MAX_FACES, faces.box(face), TRACK_IOU_THRESHOLD);
+
+        // a face without track was never filtered : nothing to hold
+        if (best < 0)
+            continue;
+
+        m_tracks[best].filter.lastFiltered(faces.landmarksX[face], faces.landmarksY[face], faces.numLandmarks);
+        matched[best] = true;
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef LANDMARKSFILTERSTAGE_H
+#define LANDMARKSFILTERSTAGE_H
+
+#include <memory>
+
+#include <opencv2/core.hpp>
+
+#include "LandmarksFilter/OneEuroFilter.h"
+#include "ResultsStage.h"
+
+/**
+ * @brief The LandmarksFilterStage class stabilizes landmarks over time
+ * Each face is followed from one result to the next (by box overlap), and all its landmarks
+ * are smoothed in place by its own OneEuroFilter, using the capture timestamps of the frames.
+ */
+class LandmarksFilterStage : public ResultsStage
+{
+public:
+    LandmarksFilterStage(std::shared_ptr<SharedQueue<FaceResultsPtr>> inFaceFeatures,
+                         std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures);
+    LandmarksFilterStage(const LandmarksFilterStage&) = delete;
+
+protected:
+    /**
+     * override void ResultsStage::process(FaceResults&);
+     * smooth landmarks of all faces in faces, in place
+     */
+    virtual void process(FaceResults& faces) override;
+
+private:
+    struct Track {
+        OneEuroFilter filter;
+        cv::Rect2f box;
+        bool active;
+    };
+
+    /**
+     * @brief holdFiltered set the landmarks of each face of faces to the last filtered ones of its track,
+     * for results older than the last filtered ones (tracks are left untouched)
+     * @param faces
+     */
+    void holdFiltered(FaceResults& faces);
+
+    // filters state is shared by all threads (process is serialized)
+    Track m_tracks[MAX_FACES];
+    double m_lastTimestamp;
+};
+
+#endif // LANDMARKSFILTERSTAGE_H
@@ -0,0 +1,108 @@
+#include "LandmarksFilter/OneEuroFilter.h"
+
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const float TWO_PI = 6.28318530718f;
+
+// Smoothing factor of an exponential low pass filter of given cutoff, for a sample period dt
+static inline float smoothingFactor(float cutoff, float dt) {
+    const float r = TWO_PI * cutoff * dt;
+    return r / (r + 1.f);
+}
+
+OneEuroFilter::OneEuroFilter(float minCutoff, float beta, float dCutoff)
+    : m_minCutoff(minCutoff),
+      m_beta(beta),
+      m_dCutoff(dCutoff),
+      m_initialized(false),
+      m_lastTimestamp(0.),
+      m_size(0)
+{
+
+}
+
+void OneEuroFilter::reset() {
+    m_initialized = false;
+}
+
+bool OneEuroFilter::operator()(float* x, float* y, int n, double timestamp, float valueScale) {
+    n = std::min(n, MAX_LANDMARKS);
+
+    if (!m_initialized || n != m_size) {
+        std::copy(x, x + n, m_prevX);
+        std::copy(y, y + n, m_prevY);
+        std::fill(m_prevSpeedX, m_prevSpeedX + n, 0.f);
+        std::fill(m_prevSpeedY, m_prevSpeedY + n, 0.f);
+        m_size = n;
+        m_lastTimestamp = timestamp;
+        m_initialized = true;
+        return true;
+    }
+
+    // same or older frame : the filtered points, rather than raw ones alternating with them downstream
+    const float dt = static_cast<float>(timestamp - m_lastTimestamp);
+    if (dt <= 0.f) {
+        lastFiltered(x, y, n);
+        return false;
+    }
+    m_lastTimestamp = timestamp;
+
+    const float speedAlpha = smoothingFactor(m_dCutoff, dt);
+    filter(x, m_prevX, m_prevSpeedX, n, dt, speedAlpha, valueScale);
+    filter(y, m_prevY, m_prevSpeedY, n, dt, speedAlpha, valueScale);
+    return true;
+}
+
+bool OneEuroFilter::lastFiltered(float* x, float* y, int n) const {
+    if (!m_initialized || std::min(n, MAX_LANDMARKS) != m_size)
+        return false;
+
+    std::copy(m_prevX, m_prevX + m_size, x);
+    std::copy(m_prevY, m_prevY + m_size, y);
+    return true;
+}
+
+void OneEuroFilter::filter(float* values, float* prevValues, float* prevSpeeds, int n,
+                           float dt, float speedAlpha, float valueScale) {
+    // per value :
+    // speed = speedAlpha * (value - prev) / dt + (1 - speedAlpha) * prevSpeed
+    // r = 2 pi dt (minCutoff + beta * |speed| * valueScale)
+    // alpha = r / (r + 1)
+    // value = prev + alpha * (value - prev)
+    const float4 v_inv_dt = set4(1.f / dt);
+    const float4 v_speed_alpha = set4(speedAlpha);
+    const float4 v_r0 = set4(TWO_PI * dt * m_minCutoff);
+    const float4 v_r1 = set4(TWO_PI * dt * m_beta * valueScale);
+    const float4 v_one = set4(1.f);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const float4 prev = load4(prevValues + i);
+        const float4 delta = sub4(load4(values + i), prev);
+
+        const float4 prev_speed = load4(prevSpeeds + i);
+        const float4 speed = madd4(prev_speed, v_speed_alpha, sub4(mul4(delta, v_inv_dt), prev_speed));
+
+        const float4 r = madd4(v_r0, v_r1, abs4(speed));
+        const float4 alpha = div4(r, add4(r, v_one));
+        const float4 filtered = madd4(prev, alpha, delta);
+
+        store4(prevSpeeds + i, speed);
+        store4(prevValues + i, filtered);
+        store4(values + i, filtered);
+    }
+
+    for (; i < n; ++i) {
+        const float delta = values[i] - prevValues[i];
+        const float speed = prevSpeeds[i] + speedAlpha * (delta / dt - prevSpeeds[i]);
+        const float alpha = smoothingFactor(m_minCutoff + m_beta * std::fabs(speed) * valueScale, dt);
+        const float filtered = prevValues[i] + alpha * delta;
+
+        prevSpeeds[i] = speed;
+        prevValues[i] = filtered;
+        values[i] = filtered;
+    }
+}
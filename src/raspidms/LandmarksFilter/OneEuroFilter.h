@@ -0,0 +1,72 @@
+#ifndef ONEEUROFILTER_H
+#define ONEEUROFILTER_H
+
+#include "FaceResults.h"
+
+/**
+ * @brief The OneEuroFilter class smooths a set of 2D points over time
+ * See "1 Euro Filter: A Simple Speed-based Low-pass Filter for Noisy Input in Interactive Systems",
+ * Casiez et al. 2012
+ *
+ * The cutoff frequency of each coordinate adapts to its speed:
+ * slow moving points are strongly smoothed (no jitter), fast moving points are barely filtered (no lag)
+ * Smoothing factors are recomputed from the actual time between two calls
+ *
+ * Points are given as separated x and y arrays (structure of arrays) and filtered in place, 4 at a time
+ */
+class OneEuroFilter
+{
+public:
+    /**
+     * @param minCutoff cutoff frequency (Hz) at zero speed
+     * @param beta speed coefficient, speed being expressed in valueScale units per second
+     * @param dCutoff cutoff frequency (Hz) of the speed estimation
+     * Defaults are the ones of mediapipe face landmarks smoothing
+     */
+    OneEuroFilter(float minCutoff = 0.05f, float beta = 80.f, float dCutoff = 1.f);
+
+    /**
+     * @brief reset forget the filter state, next call will output its input unchanged
+     */
+    void reset();
+
+    /**
+     * @brief operator () filters x and y in place
+     * @param x
+     * @param y
+     * @param n number of points, at most MAX_LANDMARKS, must not change without a reset()
+     * @param timestamp in seconds
+     * @param valueScale scale applied to the speed before beta, ex. 1 / face width to make it resolution independent
+     * @return false if timestamp is not after the one of the previous call
+     * (points are then set to the last filtered ones, see lastFiltered, and the state is left untouched)
+     */
+    bool operator()(float* x, float* y, int n, double timestamp, float valueScale = 1.f);
+
+    /**
+     * @brief lastFiltered set x and y to the points output by the last call
+     * @param x
+     * @param y
+     * @param n number of points
+     * @return false if there is no filtered points, or not n of them (x and y are then left untouched)
+     */
+    bool lastFiltered(float* x, float* y, int n) const;
+
+private:
+    void filter(float* values, float* prevValues, float* prevSpeeds, int n,
+                float dt, float speedAlpha, float valueScale);
+
+    const float m_minCutoff;
+    const float m_beta;
+    const float m_dCutoff;
+
+    bool m_initialized;
+    double m_lastTimestamp;
+    int m_size;
+
+    float m_prevX[MAX_LANDMARKS];
+    float m_prevY[MAX_LANDMARKS];
+    float m_prevSpeedX[MAX_LANDMARKS];
+    float m_prevSpeedY[MAX_LANDMARKS];
+};
+
+#endif // ONEEUROFILTER_H
@@ -0,0 +1,133 @@
+#include "Logging/FrameLog.h"
+
+#include "Utils.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+#include <new>
+
+static_assert(FRAME_LOG_MAX_FACES == MAX_FACES, "frame log format does not match FaceResults");
+static_assert(FRAME_LOG_MAX_LANDMARKS == MAX_LANDMARKS, "frame log format does not match FaceResults");
+static_assert(FRAME_LOG_NUM_STAGES == NUM_STAGES, "frame log format does not match FaceResults");
+
+FrameLog::FrameLog(const std::string& path, uint32_t capacity)
+    : m_header(nullptr),
+      m_records(nullptr),
+      m_mappedSize(0)
+{
+    if (capacity == 0)
+        capacity = 1;
+
+    const size_t size = sizeof(FrameLogHeader) + static_cast<size_t>(capacity) * sizeof(FrameLogRecord);
+
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "FrameLog: can't open " << path << std::endl;
+        return;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        std::cerr << "FrameLog: can't resize " << path << std::endl;
+        close(fd);
+        return;
+    }
+
+    // MAP_POPULATE : no page fault on the first writes of append()
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "FrameLog: can't map " << path << std::endl;
+        return;
+    }
+
+    m_mappedSize = size;
+    m_header = new (data) FrameLogHeader();
+    m_records = reinterpret_cast<FrameLogRecord*>(static_cast<char*>(data) + sizeof(FrameLogHeader));
+
+    std::memcpy(m_header->magic, FRAME_LOG_MAGIC, sizeof(FRAME_LOG_MAGIC));
+    m_header->version = FRAME_LOG_VERSION;
+    m_header->headerSize = sizeof(FrameLogHeader);
+    m_header->recordSize = sizeof(FrameLogRecord);
+    m_header->capacity = capacity;
+    m_header->maxFaces = FRAME_LOG_MAX_FACES;
+    m_header->maxLandmarks = FRAME_LOG_MAX_LANDMARKS;
+    m_header->numStages = FRAME_LOG_NUM_STAGES;
+    m_header->reserved = 0;
+    m_header->nextSequence.store(0, std::memory_order_relaxed);
+
+    // the file is zero filled : every slot starts empty (sequence 0)
+}
+
+FrameLog::~FrameLog() {
+    if (m_header) {
+        msync(m_header, m_mappedSize, MS_SYNC);
+        munmap(m_header, m_mappedSize);
+    }
+}
+
+bool FrameLog::isOpen() const {
+    return m_header != nullptr;
+}
+
+void FrameLog::append(const FaceResults& faces) {
+    if (!m_header)
+        return;
+
+    const uint64_t sequence = m_header->nextSequence.fetch_add(1, std::memory_order_relaxed) + 1;
+    FrameLogRecord& record = m_records[(sequence - 1) % m_header->capacity];
+
+    // invalid while being written
+    record.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    fillFrameLogRecord(record, faces);
+
+    record.sequence.store(sequence, std::memory_order_release);
+}
+
+void fillFrameLogRecord(FrameLogRecord& record, const FaceResults& faces) {
+    record.frameId = faces.frame.id;
+    record.captureTimestamp = faces.frame.timestamp;
+    record.detectionTimestamp = faces.detectionTimestamp;
+    record.logTimestamp = timeNow();
+
+    for (int stage = 0; stage < NUM_STAGES; ++stage) {
+        record.stageTimings[stage].duration = faces.stageTimings[stage].duration;
+        record.stageTimings[stage].threadId = faces.stageTimings[stage].threadId;
+    }
+
+    record.numFaces = faces.numFaces;
+    record.numLandmarks = faces.numLandmarks;
+    for (int face = 0; face < faces.numFaces; ++face) {
+        record.boxes[face][0] = faces.boxLeft[face];
+        record.boxes[face][1] = faces.boxTop[face];
+        record.boxes[face][2] = faces.boxRight[face];
+        record.boxes[face][3] = faces.boxBottom[face];
+        record.scores[face] = faces.scores[face];
+
+        record.hasHeadPose[face] = faces.hasHeadPose[face];
+        record.headPose[face][0] = faces.headYaw[face];
+        record.headPose[face][1] = faces.headPitch[face];
+        record.headPose[face][2] = faces.headRoll[face];
+
+        record.hasLandmarks[face] = faces.hasLandmarks[face];
+        if (faces.hasLandmarks[face]) {
+            std::memcpy(record.landmarksX[face], faces.landmarksX[face], faces.numLandmarks * sizeof(float));
+            std::memcpy(record.landmarksY[face], faces.landmarksY[face], faces.numLandmarks * sizeof(float));
+        }
+    }
+
+    const DriverState& state = faces.driverState;
+    record.driverValid = state.valid;
+    record.driverFace = state.valid ? state.face : -1;
+    record.eyesClosed = state.eyesClosed;
+    record.yawning = state.yawning;
+    record.eyeAspectRatio = state.eyeAspectRatio;
+    record.mouthAspectRatio = state.mouthAspectRatio;
+    record.perclos = state.perclos;
+    record.yawnsPerMinute = state.yawnsPerMinute;
+}
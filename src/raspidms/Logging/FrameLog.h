@@ -0,0 +1,50 @@
+#ifndef FRAMELOG_H
+#define FRAMELOG_H
+
+#include <string>
+
+#include "FaceResults.h"
+#include "Logging/FrameLogFormat.h"
+
+/**
+ * @brief The FrameLog class writes one record per result to a fixed size, memory-mapped ring file
+ * (see FrameLogFormat.h), overwriting the oldest records once full.
+ * The file is created, sized and its pages faulted in at construction ;
+ * append() then only copies to memory : no lock, no allocation, no system call.
+ * append() may be called from any number of threads at once.
+ * Data reaches the disk when the kernel writes the pages back, or at destruction.
+ *
+ * USAGE :
+ * FrameLog log("/tmp/raspidms.log", 1024);
+ * if (log.isOpen())
+ *     log.append(faces);
+ */
+class FrameLog
+{
+public:
+    FrameLog(const std::string& path, uint32_t capacity);
+    FrameLog(const FrameLog&) = delete;
+    ~FrameLog();
+
+    bool isOpen() const;
+
+    /**
+     * @brief append write faces as the next record
+     * @param faces
+     */
+    void append(const FaceResults& faces);
+
+private:
+    FrameLogHeader* m_header;
+    FrameLogRecord* m_records;
+    size_t m_mappedSize;
+};
+
+/**
+ * @brief fillFrameLogRecord copy faces to record, except its sequence
+ * @param record
+ * @param faces
+ */
+void fillFrameLogRecord(FrameLogRecord& record, const FaceResults& faces);
+
+#endif // FRAMELOG_H
@@ -0,0 +1,80 @@
+#ifndef FRAMELOGFORMAT_H
+#define FRAMELOGFORMAT_H
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Binary layout of the frame log file written by FrameLog
+ * Kept free of OpenCV / FaceResults so that reader tools only need this header.
+ *
+ * The file is a FrameLogHeader, followed by "capacity" FrameLogRecord slots used as a ring :
+ * record of sequence s (starting at 1) is in slot (s - 1) % capacity.
+ * A slot is valid when its sequence is not 0 and matches the slot ; sequence is written last,
+ * so a record being written (or torn by a crash) has sequence 0.
+ * All values are in the native endianness of the writer.
+ */
+
+const char FRAME_LOG_MAGIC[8] = {'R', 'D', 'M', 'S', 'L', 'O', 'G', '1'};
+const uint32_t FRAME_LOG_VERSION = 1;
+
+const int FRAME_LOG_MAX_FACES = 4;
+const int FRAME_LOG_MAX_LANDMARKS = 468;
+const int FRAME_LOG_NUM_STAGES = 7;
+
+// in StageId order (see FaceResults.h)
+const char* const FRAME_LOG_STAGE_NAMES[FRAME_LOG_NUM_STAGES] = {
+    "detect_faces", "face_features", "landmarks_filter", "driver_state", "head_pose", "pupils", "alerts"
+};
+
+struct FrameLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t recordSize;
+    uint32_t capacity;
+    uint32_t maxFaces;
+    uint32_t maxLandmarks;
+    uint32_t numStages;
+    uint32_t reserved;
+    std::atomic<uint64_t> nextSequence;   // sequence of the next record to be written, minus 1
+};
+
+struct FrameLogStageTiming {
+    float duration;    // seconds
+    int32_t threadId;  // -1 if the stage did not run
+};
+
+struct FrameLogRecord {
+    std::atomic<uint64_t> sequence;
+
+    int64_t frameId;
+    double captureTimestamp;     // seconds
+    double detectionTimestamp;   // capture timestamp of the frame the boxes were detected on
+    double logTimestamp;         // time the record was written
+
+    FrameLogStageTiming stageTimings[FRAME_LOG_NUM_STAGES];
+
+    int32_t numFaces;
+    int32_t numLandmarks;
+    float boxes[FRAME_LOG_MAX_FACES][4];   // left, top, right, bottom
+    float scores[FRAME_LOG_MAX_FACES];
+    uint8_t hasLandmarks[FRAME_LOG_MAX_FACES];
+    uint8_t hasHeadPose[FRAME_LOG_MAX_FACES];
+    float headPose[FRAME_LOG_MAX_FACES][3];  // yaw, pitch, roll
+    uint8_t driverValid;
+    uint8_t eyesClosed;
+    uint8_t yawning;
+    uint8_t reserved;
+    int32_t driverFace;
+    float eyeAspectRatio;
+    float mouthAspectRatio;
+    float perclos;
+    float yawnsPerMinute;
+
+    // only the first numLandmarks of faces with landmarks are meaningful
+    float landmarksX[FRAME_LOG_MAX_FACES][FRAME_LOG_MAX_LANDMARKS];
+    float landmarksY[FRAME_LOG_MAX_FACES][FRAME_LOG_MAX_LANDMARKS];
+};
+
+#endif // FRAMELOGFORMAT_H
@@ -0,0 +1,19 @@
+#include "Logging/FrameLogStage.h"
+
+const double INITIAL_AVERAGE_TIME = 0.00005;
+
+FrameLogStage::FrameLogStage(const std::string& path,
+                             uint32_t capacity,
+                             std::shared_ptr<SharedQueue<FaceResultsPtr>> inFaceFeatures,
+                             std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures)
+    : ResultsStage("frame_log", NUM_STAGES, INITIAL_AVERAGE_TIME, false, inFaceFeatures, outFaceFeatures),
+      m_log()
+{
+    if (!path.empty())
+        m_log.reset(new FrameLog(path, capacity));
+}
+
+void FrameLogStage::process(FaceResults& faces) {
+    if (m_log)
+        m_log->append(faces);
+}
@@ -0,0 +1,35 @@
+#ifndef FRAMELOGSTAGE_H
+#define FRAMELOGSTAGE_H
+
+#include <memory>
+#include <string>
+
+#include "Logging/FrameLog.h"
+#include "ResultsStage.h"
+
+/**
+ * @brief The FrameLogStage class appends every result to a FrameLog, and passes it on
+ * With an empty path, nothing is logged and results are only passed on.
+ * Results are appended from several threads at once (FrameLog::append is lock free).
+ */
+class FrameLogStage : public ResultsStage
+{
+public:
+    FrameLogStage(const std::string& path,
+                  uint32_t capacity,
+                  std::shared_ptr<SharedQueue<FaceResultsPtr>> inFaceFeatures,
+                  std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures);
+    FrameLogStage(const FrameLogStage&) = delete;
+
+protected:
+    /**
+     * override void ResultsStage::process(FaceResults&);
+     * append faces to the log
+     */
+    virtual void process(FaceResults& faces) override;
+
+private:
+    std::unique_ptr<FrameLog> m_log;
+};
+
+#endif // FRAMELOGSTAGE_H
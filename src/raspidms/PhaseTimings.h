@@ -0,0 +1,95 @@
+#ifndef PHASETIMINGS_H
+#define PHASETIMINGS_H
+
+#include <opencv2/core/utility.hpp>
+
+#include "Tracing/Tracer.h"
+
+/**
+ * @brief InferencePhase splits the time a model (IDetectFaces, IFaceFeatures) takes on a frame
+ * - preprocessing : conversion of the frame to the model input (resize, color, normalization ...)
+ * - inference : the model itself
+ * - postprocessing : decoding of the model output to FaceResults
+ */
+enum InferencePhase {
+    PHASE_PREPROCESS,
+    PHASE_INFERENCE,
+    PHASE_POSTPROCESS,
+    NUM_PHASES
+};
+
+inline const char* phaseName(InferencePhase phase) {
+    switch (phase) {
+    case PHASE_PREPROCESS: return "preprocess";
+    case PHASE_INFERENCE: return "inference";
+    case PHASE_POSTPROCESS: return "postprocess";
+    case NUM_PHASES: break;
+    }
+    return "unknown";
+}
+
+/**
+ * @brief PhaseTimings is the time in seconds spent in each phase by the last call of a model
+ */
+struct PhaseTimings {
+    double durations[NUM_PHASES];
+
+    PhaseTimings() { clear(); }
+
+    void clear() {
+        for (int phase = 0; phase < NUM_PHASES; ++phase)
+            durations[phase] = 0.;
+    }
+
+    double total() const {
+        double sum = 0.;
+        for (int phase = 0; phase < NUM_PHASES; ++phase)
+            sum += durations[phase];
+        return sum;
+    }
+};
+
+/**
+ * @brief The PhaseTimer class fills a PhaseTimings : mark(phase) adds the time since the previous mark
+ * (or the construction) to phase, so that a phase may be marked several times (e.g. once per face)
+ * Each mark is also a span of the trace, when tracing is enabled (see Tracer)
+ *
+ * USAGE :
+ * PhaseTimer timer(m_phaseTimings); // cleared
+ * resize(...);
+ * timer.mark(PHASE_PREPROCESS);
+ * net.forward(...);
+ * timer.mark(PHASE_INFERENCE);
+ */
+class PhaseTimer
+{
+public:
+    PhaseTimer(PhaseTimings& timings)
+        : m_timings(timings), m_last(cv::getTickCount())
+    {
+        m_timings.clear();
+    }
+
+    void mark(InferencePhase phase) {
+        const int64_t now = cv::getTickCount();
+        const double frequency = cv::getTickFrequency();
+        m_timings.durations[phase] += static_cast<double>(now - m_last) / frequency;
+        if (Tracer::enabled())
+            Tracer::instance().record(phaseName(phase), m_last / frequency, now / frequency);
+        m_last = now;
+    }
+
+private:
+    PhaseTimings& m_timings;
+    int64_t m_last;
+};
+
+/**
+ * @brief ModelStartupTimes is the time in seconds a model took to be created (loading), and to run its warmup frames
+ */
+struct ModelStartupTimes {
+    double load;
+    double warmup;
+};
+
+#endif // PHASETIMINGS_H
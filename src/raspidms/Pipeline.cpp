@@ -0,0 +1,100 @@
+#include "Pipeline.h"
+
+#include "Stats/AllocTracker.h"
+#include "Tracing/Tracer.h"
+#include "Utils.h"
+
+#include <thread>
+
+// preload : runs of each model on a blank frame of WARMUP_FRAME_SIZE
+const int WARMUP_RUNS = 2;
+const cv::Size WARMUP_FRAME_SIZE(640, 480);
+
+Pipeline::Pipeline(const std::string& faceDetector,
+                   const std::string& faceMesh,
+                   const std::string& logPath,
+                   uint32_t logCapacity,
+                   std::shared_ptr<IAlertSink> alertSink)
+    : inputFrameQueue(new SharedQueue<Frame>()),
+      rectsQueue(new SharedQueue<FaceResultsPtr>()),
+      rawFaceFeaturesQueue(new SharedQueue<FaceResultsPtr>()),
+      filteredFaceFeaturesQueue(new SharedQueue<FaceResultsPtr>()),
+      driverStateQueue(new SharedQueue<FaceResultsPtr>()),
+      headPoseQueue(new SharedQueue<FaceResultsPtr>()),
+      pupilsQueue(new SharedQueue<FaceResultsPtr>()),
+      alertsQueue(new SharedQueue<FaceResultsPtr>()),
+      faceFeaturesQueue(new SharedQueue<FaceResultsPtr>()),
+      detectFacesStage(faceDetector, inputFrameQueue, rectsQueue),
+      faceFeaturesStage(faceMesh, inputFrameQueue, rectsQueue, rawFaceFeaturesQueue),
+      landmarksFilterStage(rawFaceFeaturesQueue, filteredFaceFeaturesQueue),
+      driverStateStage(filteredFaceFeaturesQueue, driverStateQueue),
+      headPoseStage(driverStateQueue, headPoseQueue),
+      pupilsStage(headPoseQueue, pupilsQueue),
+      alertEngine(pupilsQueue, alertsQueue, alertSink),
+      frameLogStage(logPath, logCapacity, alertsQueue, faceFeaturesQueue)
+{
+
+}
+
+void Pipeline::runStages(int threadId) {
+    // detection and face features tag their own allocations
+    AllocScope alloc_scope(ALLOC_OTHER_STAGES);
+    detectFacesStage(threadId);
+    faceFeaturesStage(threadId);
+    landmarksFilterStage(threadId);
+    driverStateStage(threadId);
+    headPoseStage(threadId);
+    pupilsStage(threadId);
+    frameLogStage(threadId);
+}
+
+void Pipeline::preload(const std::vector<int>& threadIds, std::ostream& log) {
+    const double start = timeNow();
+
+    // mid gray, with a face box in the middle for the face mesh
+    const cv::Mat frame(WARMUP_FRAME_SIZE, CV_8UC3, cv::Scalar::all(128));
+    std::unique_ptr<FaceResults> rois(new FaceResults());
+    const cv::Point2f center(frame.cols * 0.5f, frame.rows * 0.5f);
+    const cv::Point2f half_side(frame.rows * 0.25f, frame.rows * 0.25f);
+    rois->addFace(center - half_side, center + half_side);
+
+    struct ModelStartup {
+        bool faceMesh;
+        int threadId;
+        ModelStartupTimes times;
+    };
+
+    std::vector<ModelStartup> startups;
+    for (int threadId : threadIds) {
+        startups.push_back({false, threadId, {0., 0.}});
+        startups.push_back({true, threadId, {0., 0.}});
+    }
+
+    // one thread per model
+    std::vector<std::thread> threads;
+    for (ModelStartup& startup : startups) {
+        threads.emplace_back([this, &startup, &frame, &rois]() {
+            TRACE_SPAN("preload");
+            if (startup.faceMesh)
+                startup.times = faceFeaturesStage.preloadDetector(startup.threadId, frame, *rois, WARMUP_RUNS);
+            else
+                startup.times = detectFacesStage.preloadDetector(startup.threadId, frame, WARMUP_RUNS);
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    const std::string face_detector = detectFacesStage.detectorName();
+    for (const ModelStartup& startup : startups) {
+        log << "Startup: " << (startup.faceMesh ? "face mesh " + faceFeaturesStage.detectorName()
+                                                : "face detector " + face_detector)
+            << " thread " << startup.threadId << " : load " << startup.times.load * 1000. << " ms, warmup "
+            << startup.times.warmup * 1000. << " ms" << std::endl;
+    }
+    log << "Startup: models ready in " << (timeNow() - start) * 1000. << " ms" << std::endl;
+}
+
+void Pipeline::releaseThread(int threadId) {
+    detectFacesStage.releaseDetector(threadId);
+    faceFeaturesStage.releaseDetector(threadId);
+}
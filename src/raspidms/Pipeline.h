@@ -0,0 +1,124 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Alerts/AlertEngine.h"
+#include "Alerts/IAlertSink.h"
+#include "DetectFaces/DetectFacesStage.h"
+#include "DriverState/DriverStateStage.h"
+#include "FaceFeatures/FaceFeaturesStage.h"
+#include "Gaze/PupilsStage.h"
+#include "HeadPose/HeadPoseStage.h"
+#include "LandmarksFilter/LandmarksFilterStage.h"
+#include "Logging/FrameLogStage.h"
+#include "SharedQueue.h"
+
+// frames waiting in inputFrameQueue above which the oldest are dropped
+const uint32_t MAX_IN_BUFFER_SIZE = 8;
+
+/**
+ * @brief The Pipeline struct holds the stages of raspidms and the queues between them
+ *
+ * inputFrameQueue -> DetectFacesStage -> rectsQueue -> FaceFeaturesStage -> rawFaceFeaturesQueue
+ * -> LandmarksFilterStage -> filteredFaceFeaturesQueue -> DriverStateStage -> driverStateQueue
+ * -> HeadPoseStage -> headPoseQueue -> PupilsStage -> pupilsQueue -> AlertEngine (own thread) -> alertsQueue
+ * -> FrameLogStage -> faceFeaturesQueue
+ *
+ * Frames are pushed to inputFrameQueue, the latest detection is read from rectsQueue
+ * and the latest complete results from faceFeaturesQueue (leaving at least one result in both,
+ * FaceFeaturesStage waits on rectsQueue).
+ * The stages are run by runStages(), from one thread or from several (Scheduler).
+ */
+struct Pipeline {
+    /**
+     * @param faceDetector see DetectFacesStage::createDetector
+     * @param faceMesh see FaceFeaturesStage::createDetector
+     * @param logPath frame log path, no log if empty
+     * @param logCapacity
+     * @param alertSink
+     */
+    Pipeline(const std::string& faceDetector,
+             const std::string& faceMesh,
+             const std::string& logPath,
+             uint32_t logCapacity,
+             std::shared_ptr<IAlertSink> alertSink);
+    Pipeline(const Pipeline&) = delete;
+
+    /**
+     * @brief runStages run each stage once, in order
+     * @param threadId
+     */
+    void runStages(int threadId);
+
+    /**
+     * @brief preload create the face detector and face mesh of each thread, all in parallel, and warm them up
+     * on a blank frame, so that the first frames captured are not stalled by model loading.
+     * Prints the time each model took to load and to warm up.
+     * @param threadIds threads that will run the stages
+     * @param log
+     */
+    void preload(const std::vector<int>& threadIds, std::ostream& log);
+
+    /**
+     * @brief releaseThread free what the stages keep for a thread that will not run them anymore (its detectors)
+     * @param threadId
+     */
+    void releaseThread(int threadId);
+
+    // In queue of frames
+    std::shared_ptr<SharedQueue<Frame>> inputFrameQueue;
+
+    // Out queue of rects to draw (and region of interests for feature detection)
+    std::shared_ptr<SharedQueue<FaceResultsPtr>> rectsQueue;
+
+    // Raw face features, to be filtered
+    std::shared_ptr<SharedQueue<FaceResultsPtr>> rawFaceFeaturesQueue;
+
+    // Filtered face features, to be analyzed
+    std::shared_ptr<SharedQueue<FaceResultsPtr>> filteredFaceFeaturesQueue;
+
+    // Face features with driver state, to be given a head pose
+    std::shared_ptr<SharedQueue<FaceResultsPtr>> driverStateQueue;
+
+    // Face features with head pose, to be given pupils
+    std::shared_ptr<SharedQueue<FaceResultsPtr>> headPoseQueue;
+
+    // Face features with pupils, to be checked for alerts
+    std::shared_ptr<SharedQueue<FaceResultsPtr>> pupilsQueue;
+
+    // Face features checked for alerts, to be logged
+    std::shared_ptr<SharedQueue<FaceResultsPtr>> alertsQueue;
+
+    // Face feature, driver state, head pose and pupils to be drawn
+    std::shared_ptr<SharedQueue<FaceResultsPtr>> faceFeaturesQueue;
+
+    // Responsible of detecting faces, needs in frames, and ouputs out rectangles
+    DetectFacesStage detectFacesStage;
+
+    // Responsible for detecting face feature (landmarks)
+    FaceFeaturesStage faceFeaturesStage;
+
+    // Responsible for stabilizing face features over time
+    LandmarksFilterStage landmarksFilterStage;
+
+    // Responsible for computing drowsiness indicators of the driver
+    DriverStateStage driverStateStage;
+
+    // Responsible for estimating head orientations
+    HeadPoseStage headPoseStage;
+
+    // Responsible for locating pupils
+    PupilsStage pupilsStage;
+
+    // Responsible for raising alerts, on its own thread
+    AlertEngine alertEngine;
+
+    // Responsible for logging every result (if a log path was given)
+    FrameLogStage frameLogStage;
+};
+
+#endif // PIPELINE_H
@@ -0,0 +1,73 @@
+#ifndef SHMFORMAT_H
+#define SHMFORMAT_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include "Logging/FrameLogFormat.h"
+
+/**
+ * Layout of the POSIX shared memory segment written by ShmPublisher (headless mode)
+ * Kept free of OpenCV / FaceResults so that readers only need this header.
+ *
+ * The segment is a ShmHeader followed by SHM_NUM_SLOTS slots of slotSize bytes, from slotsOffset.
+ * Each slot is a ShmSlotHeader, and the frame pixels from frameOffset (relative to the slot).
+ * The writer fills the slots in turn, and then sets latest to the slot it has just filled.
+ *
+ * The segment exists (and is sized) before its header is written : the writer stores magic last (release),
+ * a reader waits for it to match shmMagic() (acquire) before reading the rest of the header.
+ *
+ * Each slot is a seqlock : its sequence is odd while it is written. To read without ever blocking the writer :
+ * 1. slot = latest ; s1 = slot.sequence (acquire), retry if odd
+ * 2. copy what is needed from the slot
+ * 3. fence (acquire) ; s2 = slot.sequence, retry if s1 != s2
+ */
+
+const char SHM_MAGIC[8] = {'R', 'D', 'M', 'S', 'S', 'H', 'M', '1'};
+const uint32_t SHM_VERSION = 1;
+const char SHM_DEFAULT_NAME[] = "/raspidms";
+
+// with 3 slots, the slot being read is only rewritten after 2 newer frames
+const uint32_t SHM_NUM_SLOTS = 3;
+const uint32_t SHM_NO_SLOT = 0xFFFFFFFF;
+
+/**
+ * @brief shmMagic
+ * @return SHM_MAGIC as stored in ShmHeader::magic
+ */
+inline uint64_t shmMagic() {
+    uint64_t magic;
+    std::memcpy(&magic, SHM_MAGIC, sizeof(magic));
+    return magic;
+}
+
+struct ShmHeader {
+    std::atomic<uint64_t> magic;          // the bytes of SHM_MAGIC once the header is complete, 0 before
+    uint32_t version;
+    uint32_t numSlots;
+    uint64_t slotSize;
+    uint64_t slotsOffset;
+    uint64_t frameOffset;
+    uint64_t maxFrameBytes;
+    std::atomic<uint32_t> latest;         // slot of the newest frame, SHM_NO_SLOT if none yet
+    std::atomic<uint64_t> publishCount;
+};
+
+struct ShmSlotHeader {
+    std::atomic<uint64_t> sequence;
+
+    int64_t frameId;
+    double frameTimestamp;     // capture time of the frame (writer's monotonic clock, seconds)
+    double publishTimestamp;
+    int32_t width;
+    int32_t height;
+    int32_t type;              // OpenCV type (CV_8UC3 ...)
+    uint32_t step;             // bytes per row, rows are contiguous
+
+    // results of the latest processed frame, which may be older than the frame (see results.frameId)
+    uint32_t hasResults;
+    FrameLogRecord results;
+};
+
+#endif // SHMFORMAT_H
@@ -0,0 +1,128 @@
+#include "Publish/ShmPublisher.h"
+
+#include "Logging/FrameLog.h"
+#include "Utils.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+#include <new>
+
+static inline uint64_t alignTo(uint64_t size, uint64_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+ShmPublisher::ShmPublisher(const std::string& name)
+    : m_name(name),
+      m_header(nullptr),
+      m_mappedSize(0),
+      m_nextSlot(0),
+      m_failed(false)
+{
+
+}
+
+ShmPublisher::~ShmPublisher() {
+    if (!m_header)
+        return;
+
+    munmap(m_header, m_mappedSize);
+    shm_unlink(m_name.c_str());
+}
+
+bool ShmPublisher::open(const cv::Mat& image) {
+    const uint64_t max_frame_bytes = static_cast<uint64_t>(image.cols) * image.rows * image.elemSize();
+    const uint64_t frame_offset = alignTo(sizeof(ShmSlotHeader), 64);
+    const uint64_t slot_size = alignTo(frame_offset + max_frame_bytes, 4096);
+    const uint64_t slots_offset = alignTo(sizeof(ShmHeader), 4096);
+    const size_t size = slots_offset + SHM_NUM_SLOTS * slot_size;
+
+    const int fd = shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "ShmPublisher: can't open " << m_name << std::endl;
+        return false;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        std::cerr << "ShmPublisher: can't resize " << m_name << std::endl;
+        close(fd);
+        shm_unlink(m_name.c_str());
+        return false;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "ShmPublisher: can't map " << m_name << std::endl;
+        shm_unlink(m_name.c_str());
+        return false;
+    }
+
+    m_mappedSize = size;
+    m_header = new (data) ShmHeader();
+    m_header->version = SHM_VERSION;
+    m_header->numSlots = SHM_NUM_SLOTS;
+    m_header->slotSize = slot_size;
+    m_header->slotsOffset = slots_offset;
+    m_header->frameOffset = frame_offset;
+    m_header->maxFrameBytes = max_frame_bytes;
+    m_header->latest.store(SHM_NO_SLOT, std::memory_order_relaxed);
+    m_header->publishCount.store(0, std::memory_order_relaxed);
+
+    // last : readers may have mapped the segment already, the header is complete once they see the magic
+    m_header->magic.store(shmMagic(), std::memory_order_release);
+    return true;
+}
+
+bool ShmPublisher::publish(const Frame& frame, const FaceResults* faces) {
+    const cv::Mat& image = frame.image;
+    if (m_failed || image.empty())
+        return false;
+
+    if (!m_header && !open(image)) {
+        m_failed = true;
+        return false;
+    }
+
+    const size_t row_size = static_cast<size_t>(image.cols) * image.elemSize();
+    if (row_size * image.rows > m_header->maxFrameBytes)
+        return false;
+
+    char* slot_data = reinterpret_cast<char*>(m_header) + m_header->slotsOffset + m_nextSlot * m_header->slotSize;
+    ShmSlotHeader* slot = reinterpret_cast<ShmSlotHeader*>(slot_data);
+    char* pixels = slot_data + m_header->frameOffset;
+
+    // odd : being written
+    const uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->frameId = frame.id;
+    slot->frameTimestamp = frame.timestamp;
+    slot->width = image.cols;
+    slot->height = image.rows;
+    slot->type = image.type();
+    slot->step = static_cast<uint32_t>(row_size);
+    if (image.isContinuous()) {
+        std::memcpy(pixels, image.data, row_size * image.rows);
+    } else {
+        for (int y = 0; y < image.rows; ++y)
+            std::memcpy(pixels + y * row_size, image.ptr(y), row_size);
+    }
+
+    slot->hasResults = faces != nullptr;
+    if (faces)
+        fillFrameLogRecord(slot->results, *faces);
+    slot->publishTimestamp = timeNow();
+
+    // even : readable
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+
+    m_header->latest.store(m_nextSlot, std::memory_order_release);
+    m_header->publishCount.fetch_add(1, std::memory_order_release);
+    m_nextSlot = (m_nextSlot + 1) % SHM_NUM_SLOTS;
+    return true;
+}
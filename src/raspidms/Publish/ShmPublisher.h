@@ -0,0 +1,41 @@
+#ifndef SHMPUBLISHER_H
+#define SHMPUBLISHER_H
+
+#include <string>
+
+#include "FaceResults.h"
+#include "Publish/ShmFormat.h"
+
+/**
+ * @brief The ShmPublisher class publishes the latest frame and results to a POSIX shared memory segment
+ * (see ShmFormat.h), for other processes on the same machine.
+ * Slots are seqlocks : readers never block the publisher, and a frame is copied only once, into the segment.
+ * The segment is created on the first frame, sized for frames of that size, and removed at destruction.
+ * Not thread safe : one publishing thread.
+ */
+class ShmPublisher
+{
+public:
+    ShmPublisher(const std::string& name = SHM_DEFAULT_NAME);
+    ShmPublisher(const ShmPublisher&) = delete;
+    ~ShmPublisher();
+
+    /**
+     * @brief publish
+     * @param frame
+     * @param faces latest results, may be null
+     * @return false if the segment can't be created, or frame is bigger than the first one
+     */
+    bool publish(const Frame& frame, const FaceResults* faces);
+
+private:
+    bool open(const cv::Mat& image);
+
+    const std::string m_name;
+    ShmHeader* m_header;
+    size_t m_mappedSize;
+    uint32_t m_nextSlot;
+    bool m_failed;
+};
+
+#endif // SHMPUBLISHER_H
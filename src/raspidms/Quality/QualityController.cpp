@@ -0,0 +1,169 @@
+#include "Quality/QualityController.h"
+
+#include "Utils.h"
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+// rates are measured over this period, in seconds
+const double PERIOD = 1.;
+
+// below this ratio of the target rate, a period is too slow
+const double DOWN_RATE_RATIO = 0.9;
+const int DOWN_PERIODS = 2;
+
+// a period on target (above this ratio) with a load below UP_LOAD leaves room for a better level
+const double UP_RATE_RATIO = 0.97;
+const double UP_LOAD = 0.7;
+const int UP_PERIODS = 5;
+const int MAX_UP_PERIODS = 120;
+
+// periods without change after a change
+const int HOLD_PERIODS = 3;
+
+QualityController::QualityController(Pipeline& pipeline, double targetFps, const std::vector<QualityLevel>& ladder,
+                                     int workers, std::ostream& log)
+    : m_pipeline(pipeline),
+      m_targetFps(targetFps),
+      m_ladder(compiledInLevels(ladder, log)),
+      m_workers(std::max(1, workers)),
+      m_log(log),
+      m_level(0),
+      m_periodStart(timeNow()),
+      m_periodCaptured(0),
+      m_periodDetected(pipeline.detectFacesStage.detectedFrames()),
+      m_holdPeriods(HOLD_PERIODS),
+      m_slowPeriods(0),
+      m_fastPeriods(0),
+      m_upPeriods(m_ladder.size(), UP_PERIODS),
+      m_steppedUp(false)
+{
+    if (!m_ladder.empty())
+        apply(0, m_periodStart, 0., 0.);
+}
+
+std::vector<QualityLevel> QualityController::defaultLadder(const std::string& detector) {
+    return {
+        {detector, 1.f, 1, true},
+        {detector, 1.f, 1, false},
+        {detector, 0.5f, 1, false},
+        {detector, 0.5f, 2, false},
+        {detector, 0.5f, 3, false},
+    };
+}
+
+bool QualityController::readLadder(const std::string& path, std::vector<QualityLevel>& ladder) {
+    std::ifstream file(path);
+    if (!file)
+        return false;
+
+    ladder.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream fields(line);
+        QualityLevel level;
+        int secondary_landmarks = 0;
+        if (!(fields >> level.detector >> level.inputScale >> level.detectionInterval >> secondary_landmarks)
+                || level.inputScale <= 0.f || level.inputScale > 1.f || level.detectionInterval < 1)
+            return false;
+        level.secondaryLandmarks = secondary_landmarks != 0;
+
+        // switching to it would leave the pipeline without face detection
+        if (!DetectFacesStage::detectorFactory(level.detector)) {
+            std::cerr << "QualityController: face detector " << level.detector << " unknown or not compiled in" << std::endl;
+            return false;
+        }
+        ladder.push_back(level);
+    }
+    return !ladder.empty();
+}
+
+std::vector<QualityLevel> QualityController::compiledInLevels(const std::vector<QualityLevel>& ladder,
+                                                               std::ostream& log) {
+    std::vector<QualityLevel> levels;
+    for (const QualityLevel& level : ladder) {
+        if (DetectFacesStage::detectorFactory(level.detector))
+            levels.push_back(level);
+        else
+            log << "QualityController: level with face detector " << level.detector << " left out (not compiled in)" << std::endl;
+    }
+    return levels;
+}
+
+void QualityController::update(long capturedFrames) {
+    const double now = timeNow();
+    const double elapsed = now - m_periodStart;
+    if (elapsed < PERIOD || m_ladder.empty())
+        return;
+
+    const long detected = m_pipeline.detectFacesStage.detectedFrames();
+    const double rate = (detected - m_periodDetected) / elapsed;
+    const double capture_rate = (capturedFrames - m_periodCaptured) / elapsed;
+    m_periodStart = now;
+    m_periodCaptured = capturedFrames;
+    m_periodDetected = detected;
+
+    const QualityLevel& current = m_ladder[m_level];
+    const double target = std::min(m_targetFps, capture_rate);
+    const double frame_time = m_pipeline.detectFacesStage.averageTime() / current.detectionInterval
+                              + m_pipeline.faceFeaturesStage.averageTime();
+    const double load = frame_time * m_targetFps / m_workers;
+
+    if (m_holdPeriods > 0) {
+        --m_holdPeriods;
+        return;
+    }
+
+    if (rate < DOWN_RATE_RATIO * target) {
+        ++m_slowPeriods;
+        m_fastPeriods = 0;
+    } else if (rate >= UP_RATE_RATIO * target && load < UP_LOAD) {
+        ++m_fastPeriods;
+        m_slowPeriods = 0;
+    } else {
+        m_slowPeriods = 0;
+        m_fastPeriods = 0;
+    }
+
+    if (m_slowPeriods >= DOWN_PERIODS && m_level + 1 < static_cast<int>(m_ladder.size())) {
+        // the level stepped up to does not hold : try it again later
+        if (m_steppedUp)
+            m_upPeriods[m_level] = std::min(MAX_UP_PERIODS, m_upPeriods[m_level] * 2);
+        m_steppedUp = false;
+        apply(m_level + 1, now, rate, load);
+    } else if (m_level > 0 && m_fastPeriods >= m_upPeriods[m_level - 1]) {
+        m_steppedUp = true;
+        apply(m_level - 1, now, rate, load);
+    } else if (m_steppedUp && m_fastPeriods >= UP_PERIODS) {
+        // the level stepped up to holds
+        m_upPeriods[m_level] = UP_PERIODS;
+        m_steppedUp = false;
+    }
+}
+
+void QualityController::apply(int level, double now, double rate, double load) {
+    const QualityLevel& quality = m_ladder[level];
+    m_pipeline.detectFacesStage.setDetector(quality.detector);
+    m_pipeline.detectFacesStage.setInputScale(quality.inputScale);
+    m_pipeline.detectFacesStage.setDetectionInterval(quality.detectionInterval);
+    m_pipeline.faceFeaturesStage.setPrimaryFaceOnly(!quality.secondaryLandmarks);
+
+    // formatted apart, not to change the formatting of m_log (std::cout) for the others
+    std::ostringstream line;
+    line << "QualityController: " << std::fixed << std::setprecision(3) << now << " s level " << m_level
+         << " -> " << level << std::setprecision(1) << " (" << rate << " fps, target " << m_targetFps
+         << ", load " << std::setprecision(2) << load << ") : detector " << quality.detector
+         << ", input scale " << quality.inputScale << ", detection interval " << quality.detectionInterval
+         << ", secondary landmarks " << (quality.secondaryLandmarks ? "on" : "off");
+    m_log << line.str() << std::endl;
+
+    m_level = level;
+    m_holdPeriods = HOLD_PERIODS;
+    m_slowPeriods = 0;
+    m_fastPeriods = 0;
+}
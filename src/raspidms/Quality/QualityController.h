@@ -0,0 +1,105 @@
+#ifndef QUALITYCONTROLLER_H
+#define QUALITYCONTROLLER_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Pipeline.h"
+
+/**
+ * @brief QualityLevel is one step of the quality ladder : what DetectFacesStage and FaceFeaturesStage are set to
+ */
+struct QualityLevel {
+    std::string detector;         // see DetectFacesStage::createDetector
+    float inputScale;             // detection on frames resized by inputScale
+    int detectionInterval;        // detection on one frame out of detectionInterval
+    bool secondaryLandmarks;      // landmarks of every face, or of the biggest one only
+};
+
+/**
+ * @brief The QualityController class steps down a ladder of quality levels when the pipeline can not keep up
+ * with a target frame rate, and back up when it has room again.
+ *
+ * Level 0 is the best quality. Once per period, update() measures the rate of frames getting out of
+ * the face detection (distinct frames, see DetectFacesStage::detectedFrames), and estimates the load from
+ * the stage average times : (detection time / detection interval + face features time) * target fps / workers.
+ * - it steps down as soon as the rate was below DOWN_RATE_RATIO of the target for DOWN_PERIODS periods
+ * - it steps up when the rate was on target with a load below UP_LOAD for UP_PERIODS periods
+ * Hysteresis : after a change, nothing happens for HOLD_PERIODS periods (stage averages settle),
+ * and each time a level fails again right after a step up, stepping up to it takes twice as long.
+ *
+ * The target is capped by the capture rate : a slow camera does not lower the quality.
+ * Each change is logged, with a timestamp (see timeNow()).
+ *
+ * To be updated from one thread (the capture loop).
+ */
+class QualityController
+{
+public:
+    /**
+     * @param pipeline stages to set
+     * @param targetFps
+     * @param ladder from the best to the cheapest level, applied from level 0
+     * (levels with a detector that is not compiled in are left out, see DetectFacesStage::detectorFactory)
+     * @param workers threads running the stages
+     * @param log
+     */
+    QualityController(Pipeline& pipeline, double targetFps, const std::vector<QualityLevel>& ladder,
+                      int workers, std::ostream& log);
+    QualityController(const QualityController&) = delete;
+
+    /**
+     * @brief defaultLadder for a detector : all faces, then biggest face only, then smaller detection input,
+     * then detection one frame out of two, then out of three
+     * @param detector
+     * @return
+     */
+    static std::vector<QualityLevel> defaultLadder(const std::string& detector);
+
+    /**
+     * @brief readLadder read a ladder file, one level per line : detector input_scale detection_interval secondary_landmarks(0|1)
+     * lines starting with # are ignored
+     * @param path
+     * @param ladder
+     * @return false if the file can't be read or a line is invalid (including a detector that is not compiled in)
+     */
+    static bool readLadder(const std::string& path, std::vector<QualityLevel>& ladder);
+
+    /**
+     * @brief update to be called once per captured frame
+     * @param capturedFrames frames captured so far
+     */
+    void update(long capturedFrames);
+
+    int level() const { return m_level; }
+
+private:
+    /**
+     * @brief compiledInLevels
+     * @param ladder
+     * @param log
+     * @return the levels of ladder with a detector compiled in (the others are logged)
+     */
+    static std::vector<QualityLevel> compiledInLevels(const std::vector<QualityLevel>& ladder, std::ostream& log);
+
+    void apply(int level, double now, double rate, double load);
+
+    Pipeline& m_pipeline;
+    const double m_targetFps;
+    const std::vector<QualityLevel> m_ladder;
+    const int m_workers;
+    std::ostream& m_log;
+
+    int m_level;
+    double m_periodStart;
+    long m_periodCaptured;
+    long m_periodDetected;
+    int m_holdPeriods;
+    int m_slowPeriods;
+    int m_fastPeriods;
+    std::vector<int> m_upPeriods;   // periods on target needed to step up to each level
+    bool m_steppedUp;
+};
+
+#endif // QUALITYCONTROLLER_H
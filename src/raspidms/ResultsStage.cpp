@@ -0,0 +1,58 @@
+#include "ResultsStage.h"
+
+#include "Tracing/Tracer.h"
+#include "Utils.h"
+
+const size_t MAX_OUT_QUEUE_SIZE = 2;
+const double AVERAGE_ALPHA = 0.1;
+
+ResultsStage::ResultsStage(const char* name,
+                           StageId stage,
+                           double initialAverageTime,
+                           bool serialized,
+                           std::shared_ptr<SharedQueue<FaceResultsPtr>> inFaceFeatures,
+                           std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures)
+    : m_name(name),
+      m_stage(stage),
+      m_serialized(serialized),
+      m_inFaceFeatures(inFaceFeatures),
+      m_outFaceFeatures(outFaceFeatures),
+      m_mutex(),
+      m_averageTime(initialAverageTime),
+      m_averageAlpha(AVERAGE_ALPHA)
+{
+
+}
+
+void ResultsStage::operator()(int threadId) {
+    TRACE_SPAN(m_name);
+    FaceResultsPtr faces;
+    while (m_inFaceFeatures->pop_front_no_wait(faces)) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+            if (m_serialized)
+                lock.lock();
+
+            const double start = timeNow();
+            process(*faces);
+            const double duration = timeNow() - start;
+
+            if (m_stage != NUM_STAGES)
+                faces->setStageTiming(m_stage, duration, threadId);
+
+            if (!m_serialized)
+                lock.lock();
+            // Exponential moving average
+            m_averageTime = m_averageAlpha * duration + (1. - m_averageAlpha) * m_averageTime;
+        }
+
+        m_outFaceFeatures->push_back(std::move(faces));
+
+        if (m_outFaceFeatures->size() > MAX_OUT_QUEUE_SIZE)
+            m_outFaceFeatures->pop_front_no_wait();
+    }
+}
+
+double ResultsStage::averageTime() {
+    return m_averageTime;
+}
@@ -0,0 +1,71 @@
+#ifndef RESULTSSTAGE_H
+#define RESULTSSTAGE_H
+
+#include <memory>
+#include <mutex>
+
+#include "IStage.h"
+#include "SharedQueue.h"
+
+/**
+ * @brief The ResultsStage class is the base of the stages that work on results, one after the other :
+ * each result popped from inFaceFeatures goes through process(), is timed, and is pushed to outFaceFeatures
+ * (trimmed to its newest results).
+ * Results are popped from inFaceFeatures, of which the stage must be the only consumer.
+ *
+ * USAGE :
+ * class MyStage : public ResultsStage {
+ *     MyStage(in, out) : ResultsStage("my_stage", STAGE_MY_STAGE, 0.0001, true, in, out) {}
+ *     virtual void process(FaceResults& faces) override;
+ * };
+ */
+class ResultsStage : public IStage
+{
+public:
+    /**
+     * @param name trace span name
+     * @param stage timing written to each result, none if NUM_STAGES
+     * @param initialAverageTime in seconds
+     * @param serialized process() is called under the stage mutex (when it keeps a state over time)
+     * @param inFaceFeatures
+     * @param outFaceFeatures
+     */
+    ResultsStage(const char* name,
+                 StageId stage,
+                 double initialAverageTime,
+                 bool serialized,
+                 std::shared_ptr<SharedQueue<FaceResultsPtr>> inFaceFeatures,
+                 std::shared_ptr<SharedQueue<FaceResultsPtr>> outFaceFeatures);
+    ResultsStage(const ResultsStage&) = delete;
+
+    /**
+     * override void IStage::operator()(int);
+     * Does not block : returns if there is no new result to process
+     */
+    virtual void operator()(int threadId) override;
+
+    /**
+     * override double IStage::averageTime();
+     */
+    virtual double averageTime() override;
+
+protected:
+    /**
+     * @brief process work on faces, in place
+     * @param faces
+     */
+    virtual void process(FaceResults& faces) = 0;
+
+private:
+    const char* const m_name;
+    const StageId m_stage;
+    const bool m_serialized;
+    std::shared_ptr<SharedQueue<FaceResultsPtr>> m_inFaceFeatures;
+    std::shared_ptr<SharedQueue<FaceResultsPtr>> m_outFaceFeatures;
+
+    std::mutex m_mutex;    // guards process() if serialized, and the average time
+    double m_averageTime;
+    double m_averageAlpha;
+};
+
+#endif // RESULTSSTAGE_H
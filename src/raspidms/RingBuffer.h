@@ -0,0 +1,164 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief The RingBuffer class is a fixed capacity FIFO, allocated once at construction
+ * When full, push_back overwrites the oldest element
+ * Not thread safe
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+    RingBuffer(size_t capacity);
+
+    //push an element at back, dropping the oldest one if full
+    void push_back(const T& item);
+
+    //remove the oldest element, must not be empty
+    void pop_front();
+
+    //oldest element, must not be empty
+    const T& front() const;
+
+    //newest element, must not be empty
+    const T& back() const;
+
+    //i-th element from the oldest one
+    const T& operator[](size_t i) const;
+
+    void clear();
+
+    size_t size() const;
+    size_t capacity() const;
+    bool empty() const;
+    bool full() const;
+
+private:
+    std::vector<T> m_items;
+    size_t m_head;
+    size_t m_size;
+};
+
+template <typename T>
+RingBuffer<T>::RingBuffer(size_t capacity)
+    : m_items(capacity > 0 ? capacity : 1),
+      m_head(0),
+      m_size(0)
+{
+
+}
+
+template <typename T>
+void RingBuffer<T>::push_back(const T& item)
+{
+    m_items[(m_head + m_size) % m_items.size()] = item;
+    if (m_size < m_items.size())
+        ++m_size;
+    else
+        m_head = (m_head + 1) % m_items.size();
+}
+
+template <typename T>
+void RingBuffer<T>::pop_front()
+{
+    m_head = (m_head + 1) % m_items.size();
+    --m_size;
+}
+
+template <typename T>
+const T& RingBuffer<T>::front() const
+{
+    return m_items[m_head];
+}
+
+template <typename T>
+const T& RingBuffer<T>::back() const
+{
+    return m_items[(m_head + m_size - 1) % m_items.size()];
+}
+
+template <typename T>
+const T& RingBuffer<T>::operator[](size_t i) const
+{
+    return m_items[(m_head + i) % m_items.size()];
+}
+
+template <typename T>
+void RingBuffer<T>::clear()
+{
+    m_head = 0;
+    m_size = 0;
+}
+
+template <typename T>
+size_t RingBuffer<T>::size() const
+{
+    return m_size;
+}
+
+template <typename T>
+size_t RingBuffer<T>::capacity() const
+{
+    return m_items.size();
+}
+
+template <typename T>
+bool RingBuffer<T>::empty() const
+{
+    return m_size == 0;
+}
+
+template <typename T>
+bool RingBuffer<T>::full() const
+{
+    return m_size == m_items.size();
+}
+
+/**
+ * @brief The SlidingWindow class keeps the running sum of the values pushed during the last "duration" seconds
+ * Each push is O(1) amortized : expired values are subtracted from the sum as they leave the window
+ * If more than "capacity" values are pushed within the duration, the oldest ones leave the window early
+ * Not thread safe
+ */
+class SlidingWindow
+{
+public:
+    SlidingWindow(double duration, size_t capacity)
+        : m_samples(capacity), m_duration(duration), m_sum(0.) {}
+
+    //add value at timestamp (seconds), timestamps must not decrease
+    void push(double timestamp, double value) {
+        if (m_samples.full()) {
+            m_sum -= m_samples.front().second;
+            m_samples.pop_front();
+        }
+        m_samples.push_back({timestamp, value});
+        m_sum += value;
+
+        while (!m_samples.empty() && m_samples.front().first < timestamp - m_duration) {
+            m_sum -= m_samples.front().second;
+            m_samples.pop_front();
+        }
+    }
+
+    void clear() { m_samples.clear(); m_sum = 0.; }
+
+    double sum() const { return m_sum; }
+    size_t count() const { return m_samples.size(); }
+    double mean() const { return m_samples.empty() ? 0. : m_sum / m_samples.size(); }
+
+    //time (seconds) covered by the values in the window
+    double span() const { return m_samples.size() < 2 ? 0. : m_samples.back().first - m_samples.front().first; }
+
+private:
+    RingBuffer<std::pair<double /*timestamp*/, double /*value*/>> m_samples;
+    const double m_duration;
+    double m_sum;
+};
+
+#endif // RINGBUFFER_H
@@ -3,22 +3,58 @@
 #include <iostream>
 #include <limits>
 
+#include "Stats/AllocTracker.h"
 #include "Utils.h"
 
+// auto resize : load averaged over this period, in seconds
+const double RESIZE_PERIOD = 1.;
 
-Scheduler::Scheduler()
+// grow when the queue holds more than GROW_QUEUE_DEPTH items on average (the consumers leave one)
+// and less than GROW_IDLE_RATIO of the threads are idle, for GROW_PERIODS periods
+const double GROW_QUEUE_DEPTH = 2.;
+const double GROW_IDLE_RATIO = 0.1;
+const int GROW_PERIODS = 2;
+
+// shrink when more than SHRINK_IDLE_RATIO of the threads are idle and the queue does not build up, for SHRINK_PERIODS periods
+const double SHRINK_IDLE_RATIO = 0.4;
+const int SHRINK_PERIODS = 3;
+
+// periods without resize after a resize
+const int HOLD_PERIODS = 2;
+
+Scheduler::Scheduler(int nThreads)
     : m_funcMap(),
       m_idPQ([](id_timing_t left, id_timing_t right) { return left.first > right.first; }),
-      m_threadPool(4,
+      m_threadPool(nThreads,
                    std::bind(&Scheduler::timingCb,
                    this,
                    std::placeholders::_1,
-                   std::placeholders::_2))
+                   std::placeholders::_2)),
+      m_threadCount(nThreads),
+      m_minThreads(nThreads),
+      m_maxThreads(nThreads),
+      m_queueDepth(),
+      m_resizePeriodStart(0.),
+      m_loadSamples(0),
+      m_idleRatioSum(0.),
+      m_queueDepthSum(0.),
+      m_growPeriods(0),
+      m_shrinkPeriods(0),
+      m_holdPeriods(0),
+      m_threadRetiredCb(),
+      m_retiringThreads(0),
+      m_stopping(false)
 {
-
+    m_threadPool.set_retired_callback(std::bind(&Scheduler::retiredCb, this, std::placeholders::_1));
 }
 
 Scheduler::~Scheduler() {
+    stop();
+}
+
+void Scheduler::stop() {
+    // joins every thread, the retired ones included, before the members they use are destroyed
+    m_stopping = true;
     m_threadPool.stop();
 }
 
@@ -65,7 +101,90 @@ void Scheduler::timingCb(long id, double time) {
     m_idPQ.push({pack.time_acc, id});
 }
 
+void Scheduler::setAutoResize(int minThreads, int maxThreads, std::function<size_t()> queueDepth) {
+    m_minThreads = std::max(1, minThreads);
+    m_maxThreads = std::max(m_minThreads, maxThreads);
+    m_queueDepth = queueDepth;
+    m_resizePeriodStart = timeNow();
+
+    const int n_threads = std::min(m_maxThreads, std::max(m_minThreads, threadCount()));
+    if (n_threads != threadCount()) {
+        if (n_threads < threadCount())
+            m_retiringThreads += threadCount() - n_threads;
+        m_threadPool.resize(n_threads);
+        m_threadCount = n_threads;
+    }
+}
+
+void Scheduler::setThreadRetiredCb(std::function<void(int)> retiredCb) {
+    m_threadRetiredCb = retiredCb;
+}
+
+void Scheduler::retiredCb(int threadId) {
+    if (m_threadRetiredCb)
+        m_threadRetiredCb(threadId);
+    if (!m_stopping)
+        --m_retiringThreads;
+}
+
+void Scheduler::autoResize() {
+    const int n_threads = threadCount();
+    m_idleRatioSum += static_cast<double>(m_threadPool.n_idle()) / std::max(1, n_threads);
+    m_queueDepthSum += m_queueDepth();
+    ++m_loadSamples;
+
+    const double now = timeNow();
+    if (now - m_resizePeriodStart < RESIZE_PERIOD)
+        return;
+
+    const double idle_ratio = m_idleRatioSum / m_loadSamples;
+    const double queue_depth = m_queueDepthSum / m_loadSamples;
+    m_resizePeriodStart = now;
+    m_idleRatioSum = 0.;
+    m_queueDepthSum = 0.;
+    m_loadSamples = 0;
+
+    if (m_holdPeriods > 0) {
+        --m_holdPeriods;
+        return;
+    }
+
+    const bool overloaded = queue_depth > GROW_QUEUE_DEPTH && idle_ratio < GROW_IDLE_RATIO;
+    const bool underloaded = queue_depth <= GROW_QUEUE_DEPTH && idle_ratio > SHRINK_IDLE_RATIO;
+    m_growPeriods = overloaded ? m_growPeriods + 1 : 0;
+    m_shrinkPeriods = underloaded ? m_shrinkPeriods + 1 : 0;
+
+    int new_n_threads = n_threads;
+    // a thread id must not be given to a new thread while a retired one may still use it
+    if (m_growPeriods >= GROW_PERIODS && n_threads < m_maxThreads && m_retiringThreads == 0)
+        new_n_threads = n_threads + 1;
+    else if (m_shrinkPeriods >= SHRINK_PERIODS && n_threads > m_minThreads)
+        new_n_threads = n_threads - 1;
+
+    if (new_n_threads == n_threads)
+        return;
+
+    std::cout << "Scheduler: " << now << " s resize " << n_threads << " -> " << new_n_threads << " threads (idle "
+              << idle_ratio << ", queue depth " << queue_depth << ")" << std::endl;
+
+    if (new_n_threads < n_threads)
+        ++m_retiringThreads;
+    m_threadPool.resize(new_n_threads);
+    m_threadCount = new_n_threads;
+    m_growPeriods = 0;
+    m_shrinkPeriods = 0;
+    m_holdPeriods = HOLD_PERIODS;
+}
+
 void Scheduler::schedule() {
+    AllocScope alloc_scope(ALLOC_SCHEDULER);
+
+    if (m_stopping)
+        return;
+
+    if (m_queueDepth)
+        autoResize();
+
     if (m_threadPool.queue_size() > 0 || m_threadPool.n_idle() == 0)
         return;
 
@@ -1,6 +1,7 @@
 #ifndef SCHEDULER_H
 #define SCHEDULER_H
 
+#include <atomic>
 #include <functional>
 #include <deque>
 #include <unordered_map>
@@ -10,10 +11,12 @@
 
 typedef std::function<void(int)> SchedFunc;
 
+const int DEFAULT_SCHEDULER_THREADS = 4;
+
 class Scheduler
 {
 public:
-    Scheduler();
+    Scheduler(int nThreads = DEFAULT_SCHEDULER_THREADS);
     ~Scheduler();
 
     /**
@@ -47,6 +50,44 @@ public:
      */
     void schedule();
 
+    /**
+     * @brief stop wait for the running functions to finish, drop the queued ones, and stop the threads
+     * (also done by the destructor). schedule() does nothing afterwards.
+     */
+    void stop();
+
+    /**
+     * @brief setAutoResize let schedule() grow and shrink the pool, one thread at a time, between minThreads and maxThreads :
+     * - grow when the queue feeding the functions stays deep and the threads are all busy
+     * - shrink when the threads stay idle and the queue does not build up
+     * Retired threads finish their task first, and call the retired callback (see setThreadRetiredCb)
+     * Not called again to grow until every retired thread is gone, so that a thread id is never used by two threads.
+     * @param minThreads >= 1
+     * @param maxThreads >= minThreads
+     * @param queueDepth depth of the queue feeding the functions (e.g. input frames), lock free, called from schedule()
+     */
+    void setAutoResize(int minThreads, int maxThreads, std::function<size_t()> queueDepth);
+
+    /**
+     * @brief setThreadRetiredCb called by a thread of the pool when it retires (pool shrunk, or stopped),
+     * after its last function, with its id : to free the resources kept for this thread id
+     * To be set before the first schedule()
+     * @param retiredCb
+     */
+    void setThreadRetiredCb(std::function<void(int)> retiredCb);
+
+    /**
+     * @brief threadCount
+     * @return number of threads of the pool
+     */
+    int threadCount() const { return m_threadCount.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief idleThreads
+     * @return number of threads of the pool waiting for a task (lock free, see ThreadPool::n_idle)
+     */
+    int idleThreads() { return m_threadPool.n_idle(); }
+
 private:
     struct SchedFuncPack {
         SchedFunc func;
@@ -61,6 +102,13 @@ private:
      */
     void timingCb(long id, double time);
 
+    /**
+     * @brief autoResize sample the load, and resize the pool once per resize period (see setAutoResize)
+     */
+    void autoResize();
+
+    void retiredCb(int threadId);
+
     // map of SchedFuncPack
     std::unordered_map<long /*id*/, SchedFuncPack> m_funcMap;
 
@@ -69,6 +117,23 @@ private:
     std::priority_queue<id_timing_t, std::vector<id_timing_t>, std::function<bool(id_timing_t, id_timing_t)>> m_idPQ;
 
     ThreadPool m_threadPool;
+    std::atomic<int> m_threadCount;
+
+    // auto resize, only used by the thread calling schedule()
+    int m_minThreads;
+    int m_maxThreads;
+    std::function<size_t()> m_queueDepth;
+    double m_resizePeriodStart;
+    int m_loadSamples;
+    double m_idleRatioSum;
+    double m_queueDepthSum;
+    int m_growPeriods;
+    int m_shrinkPeriods;
+    int m_holdPeriods;
+
+    std::function<void(int)> m_threadRetiredCb;
+    std::atomic<int> m_retiringThreads;    // retired by a resize, still finishing their task
+    std::atomic<bool> m_stopping;          // stop() called : threads retiring now were not retired by a resize
 };
 
 #endif // SCHEDULER_H
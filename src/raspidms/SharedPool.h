@@ -0,0 +1,69 @@
+#ifndef SHAREDPOOL_H
+#define SHAREDPOOL_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief The SharedPool class recycles objects handed out as std::shared_ptr
+ * An object is free again as soon as every shared_ptr given by acquire() on it is released,
+ * so that once the pool has grown to the number of objects in flight, acquire() never allocates.
+ *
+ * USAGE :
+ * SharedPool<FaceResults> pool;
+ * std::shared_ptr<FaceResults> results = pool.acquire();
+ * queue.push_back(std::move(results)); // back to the pool once every consumer dropped it
+ */
+template <typename T>
+class SharedPool
+{
+public:
+    SharedPool(size_t initialSize = 0);
+
+    //return an object that nobody else holds
+    //allocate a new one only if all objects are in use
+    std::shared_ptr<T> acquire();
+
+    //total number of objects owned by the pool
+    size_t size();
+
+private:
+    std::vector<std::shared_ptr<T>> m_objects;
+    std::mutex m_mutex;
+};
+
+template <typename T>
+SharedPool<T>::SharedPool(size_t initialSize)
+{
+    for (size_t i = 0; i < initialSize; ++i)
+        m_objects.push_back(std::make_shared<T>());
+}
+
+template <typename T>
+std::shared_ptr<T> SharedPool<T>::acquire()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    for (const auto& object : m_objects) {
+        // Copies are only made here, under the mutex, so a count of 1
+        // (the pool's own) can not grow behind our back
+        if (object.use_count() == 1) {
+            // pairs with the release of the last user's reference
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return object;
+        }
+    }
+
+    m_objects.push_back(std::make_shared<T>());
+    return m_objects.back();
+}
+
+template <typename T>
+size_t SharedPool<T>::size()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_objects.size();
+}
+
+#endif // SHAREDPOOL_H
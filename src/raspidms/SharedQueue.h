@@ -1,6 +1,7 @@
 #ifndef SHAREDQUEUE_H
 #define SHAREDQUEUE_H
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <queue>
@@ -43,14 +44,19 @@ public:
     size_t size();
     bool empty();
 
+    //size without taking the lock, possibly already outdated
+    //(for monitoring, never blocks the producers and consumers)
+    size_t size_no_lock() const;
+
 private:
     std::deque<T> m_queue;
     std::mutex m_mutex;
     std::condition_variable m_cv;
+    std::atomic<size_t> m_size;
 };
 
 template <typename T>
-SharedQueue<T>::SharedQueue(){}
+SharedQueue<T>::SharedQueue() : m_size(0) {}
 
 template <typename T>
 SharedQueue<T>::~SharedQueue(){}
@@ -83,6 +89,7 @@ bool SharedQueue<T>::pop_front_no_wait()
     if (m_queue.empty())
         return false;
     m_queue.pop_front();
+    m_size.store(m_queue.size(), std::memory_order_relaxed);
     return true;
 }
 
@@ -94,6 +101,7 @@ bool SharedQueue<T>::pop_front_no_wait(T& item)
         return false;
     item = m_queue.front();
     m_queue.pop_front();
+    m_size.store(m_queue.size(), std::memory_order_relaxed);
     return true;
 }
 
@@ -107,6 +115,7 @@ void SharedQueue<T>::pop_front_wait(T& item)
     }
     item = m_queue.front();
     m_queue.pop_front();
+    m_size.store(m_queue.size(), std::memory_order_relaxed);
 }
 
 template <typename T>
@@ -114,6 +123,7 @@ void SharedQueue<T>::push_back(const T& item)
 {
     std::unique_lock<std::mutex> mlock(m_mutex);
     m_queue.push_back(item);
+    m_size.store(m_queue.size(), std::memory_order_relaxed);
     mlock.unlock();     // unlock before notification to minimize mutex con
     m_cv.notify_one(); // notify one waiting thread
 }
@@ -123,6 +133,7 @@ void SharedQueue<T>::push_back(T&& item)
 {
     std::unique_lock<std::mutex> mlock(m_mutex);
     m_queue.push_back(std::move(item));
+    m_size.store(m_queue.size(), std::memory_order_relaxed);
     mlock.unlock();     // unlock before notification to minimize mutex con
     m_cv.notify_one(); // notify one waiting thread
 }
@@ -136,6 +147,12 @@ size_t SharedQueue<T>::size()
     return size;
 }
 
+template <typename T>
+size_t SharedQueue<T>::size_no_lock() const
+{
+    return m_size.load(std::memory_order_relaxed);
+}
+
 template <typename T>
 bool SharedQueue<T>::empty()
 {
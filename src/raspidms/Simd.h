@@ -0,0 +1,85 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+/**
+ * Minimal 4 x float SIMD abstraction
+ * NEON on ARM (Raspberry Pi), SSE2 on x86, plain C++ otherwise
+ * Loads and stores are unaligned
+ */
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+
+typedef float32x4_t float4;
+
+inline float4 load4(const float* p) { return vld1q_f32(p); }
+inline void store4(float* p, float4 a) { vst1q_f32(p, a); }
+inline float4 set4(float a) { return vdupq_n_f32(a); }
+inline float4 add4(float4 a, float4 b) { return vaddq_f32(a, b); }
+inline float4 sub4(float4 a, float4 b) { return vsubq_f32(a, b); }
+inline float4 mul4(float4 a, float4 b) { return vmulq_f32(a, b); }
+inline float4 abs4(float4 a) { return vabsq_f32(a); }
+inline float4 min4(float4 a, float4 b) { return vminq_f32(a, b); }
+inline float4 max4(float4 a, float4 b) { return vmaxq_f32(a, b); }
+// a + b * c
+inline float4 madd4(float4 a, float4 b, float4 c) { return vmlaq_f32(a, b, c); }
+inline float4 div4(float4 a, float4 b) {
+    // armv7 has no vector division : reciprocal estimate refined by two Newton-Raphson steps
+    float4 r = vrecpeq_f32(b);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    return vmulq_f32(a, r);
+}
+inline float sum4(float4 a) {
+    float32x2_t s = vadd_f32(vget_low_f32(a), vget_high_f32(a));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+}
+
+#elif defined(__SSE2__)
+
+#include <emmintrin.h>
+
+typedef __m128 float4;
+
+inline float4 load4(const float* p) { return _mm_loadu_ps(p); }
+inline void store4(float* p, float4 a) { _mm_storeu_ps(p, a); }
+inline float4 set4(float a) { return _mm_set1_ps(a); }
+inline float4 add4(float4 a, float4 b) { return _mm_add_ps(a, b); }
+inline float4 sub4(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+inline float4 mul4(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+inline float4 abs4(float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+inline float4 min4(float4 a, float4 b) { return _mm_min_ps(a, b); }
+inline float4 max4(float4 a, float4 b) { return _mm_max_ps(a, b); }
+// a + b * c
+inline float4 madd4(float4 a, float4 b, float4 c) { return _mm_add_ps(a, _mm_mul_ps(b, c)); }
+inline float4 div4(float4 a, float4 b) { return _mm_div_ps(a, b); }
+inline float sum4(float4 a) {
+    float4 s = _mm_add_ps(a, _mm_movehl_ps(a, a));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+#else
+
+#include <cmath>
+
+struct float4 { float v[4]; };
+
+inline float4 load4(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline void store4(float* p, float4 a) { for (int i = 0; i < 4; ++i) p[i] = a.v[i]; }
+inline float4 set4(float a) { return {{a, a, a, a}}; }
+inline float4 add4(float4 a, float4 b) { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+inline float4 sub4(float4 a, float4 b) { for (int i = 0; i < 4; ++i) a.v[i] -= b.v[i]; return a; }
+inline float4 mul4(float4 a, float4 b) { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+inline float4 abs4(float4 a) { for (int i = 0; i < 4; ++i) a.v[i] = std::fabs(a.v[i]); return a; }
+inline float4 min4(float4 a, float4 b) { for (int i = 0; i < 4; ++i) a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return a; }
+inline float4 max4(float4 a, float4 b) { for (int i = 0; i < 4; ++i) a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return a; }
+// a + b * c
+inline float4 madd4(float4 a, float4 b, float4 c) { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i] * c.v[i]; return a; }
+inline float4 div4(float4 a, float4 b) { for (int i = 0; i < 4; ++i) a.v[i] /= b.v[i]; return a; }
+inline float sum4(float4 a) { return a.v[0] + a.v[1] + a.v[2] + a.v[3]; }
+
+#endif
+
+#endif // SIMD_H
@@ -0,0 +1,167 @@
+#include "Stats/AllocTracker.h"
+
+#include "Utils.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+struct AtomicAllocCounts {
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> frees;
+};
+
+// zero initialized, usable by the operators before any constructor ran
+AtomicAllocCounts g_counts[NUM_ALLOC_TAGS];
+
+thread_local AllocTag t_tag = ALLOC_UNTAGGED;
+
+}
+
+std::atomic<bool> AllocTracker::s_enabled(false);
+
+bool AllocTracker::compiledIn() {
+#ifdef RASPIDMS_ALLOC_TRACKER
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AllocTracker::start() {
+    s_enabled.store(true, std::memory_order_relaxed);
+}
+
+AllocSnapshot AllocTracker::snapshot() {
+    AllocSnapshot snapshot;
+    for (int tag = 0; tag < NUM_ALLOC_TAGS; ++tag) {
+        snapshot.counts[tag].allocations = g_counts[tag].allocations.load(std::memory_order_relaxed);
+        snapshot.counts[tag].bytes = g_counts[tag].bytes.load(std::memory_order_relaxed);
+        snapshot.counts[tag].frees = g_counts[tag].frees.load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+AllocTag AllocTracker::setThreadTag(AllocTag tag) {
+    const AllocTag previous = t_tag;
+    t_tag = tag;
+    return previous;
+}
+
+void AllocTracker::recordAllocation(size_t size) {
+    AtomicAllocCounts& counts = g_counts[t_tag];
+    counts.allocations.fetch_add(1, std::memory_order_relaxed);
+    counts.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void AllocTracker::recordFree() {
+    g_counts[t_tag].frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void printCounts(std::ostream& out, const char* name, const AllocCounts& counts, long frames) {
+    const double perFrame = frames > 0 ? 1. / frames : 0.;
+    out << "    " << name << " : " << counts.allocations << " allocations, " << counts.bytes << " bytes, "
+        << counts.frees << " frees, per frame " << counts.allocations * perFrame << " allocations, "
+        << counts.bytes * perFrame << " bytes" << std::endl;
+}
+
+void AllocTracker::printReport(std::ostream& out, long frames, const AllocSnapshot* since, long framesSince) {
+    if (!compiledIn()) {
+        out << "Allocations not tracked, build with RASPIDMS_ALLOC_TRACKER" << std::endl;
+    } else {
+        const AllocSnapshot now = snapshot();
+        out << "Allocations over " << frames << " frames :" << std::endl;
+        for (int tag = 0; tag < NUM_ALLOC_TAGS; ++tag)
+            printCounts(out, allocTagName(static_cast<AllocTag>(tag)), now.counts[tag], frames);
+
+        if (since) {
+            out << "Allocations over the last " << framesSince << " frames (steady state) :" << std::endl;
+            for (int tag = 0; tag < NUM_ALLOC_TAGS; ++tag) {
+                const AllocCounts counts = {now.counts[tag].allocations - since->counts[tag].allocations,
+                                            now.counts[tag].bytes - since->counts[tag].bytes,
+                                            now.counts[tag].frees - since->counts[tag].frees};
+                printCounts(out, allocTagName(static_cast<AllocTag>(tag)), counts, framesSince);
+            }
+        }
+    }
+    out << "Peak RSS " << peakRssKb() << " KB" << std::endl;
+}
+
+#ifdef RASPIDMS_ALLOC_TRACKER
+
+// replacements of the global operators, on malloc / free
+
+static void* allocate(std::size_t size) {
+    for (;;) {
+        void* ptr = std::malloc(size ? size : 1);
+        if (ptr) {
+            if (AllocTracker::enabled())
+                AllocTracker::recordAllocation(size);
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+static void deallocate(void* ptr) noexcept {
+    if (!ptr)
+        return;
+    if (AllocTracker::enabled())
+        AllocTracker::recordFree();
+    std::free(ptr);
+}
+
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* ptr) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+#endif
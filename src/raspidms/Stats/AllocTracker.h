@@ -0,0 +1,117 @@
+#ifndef ALLOCTRACKER_H
+#define ALLOCTRACKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @brief AllocTag is what allocations are attributed to, set per thread with AllocScope
+ */
+enum AllocTag {
+    ALLOC_UNTAGGED,
+    ALLOC_MAIN_LOOP,
+    ALLOC_SCHEDULER,        // Scheduler and ThreadPool bookkeeping (task functions, timings)
+    ALLOC_DETECT_FACES,
+    ALLOC_FACE_FEATURES,
+    ALLOC_OTHER_STAGES,     // every other stage run by Pipeline::runStages
+    NUM_ALLOC_TAGS
+};
+
+inline const char* allocTagName(AllocTag tag) {
+    switch (tag) {
+    case ALLOC_UNTAGGED: return "untagged";
+    case ALLOC_MAIN_LOOP: return "main_loop";
+    case ALLOC_SCHEDULER: return "scheduler";
+    case ALLOC_DETECT_FACES: return "detect_faces";
+    case ALLOC_FACE_FEATURES: return "face_features";
+    case ALLOC_OTHER_STAGES: return "other_stages";
+    case NUM_ALLOC_TAGS: break;
+    }
+    return "unknown";
+}
+
+/**
+ * @brief AllocCounts are the allocations made, and the frees, under a tag
+ * A free is attributed to the tag of the thread freeing, which may not be the one that allocated
+ */
+struct AllocCounts {
+    uint64_t allocations;
+    uint64_t bytes;
+    uint64_t frees;
+};
+
+// counts of every tag at one time
+struct AllocSnapshot {
+    AllocCounts counts[NUM_ALLOC_TAGS];
+};
+
+/**
+ * @brief The AllocTracker class counts the calls to the global operator new / delete, per AllocTag.
+ *
+ * The operators are only replaced when built with the CMake option RASPIDMS_ALLOC_TRACKER (compiledIn()),
+ * and only count once start() was called : until then they cost a relaxed atomic load over malloc / free.
+ * Counting takes no lock and never allocates.
+ *
+ * USAGE :
+ * AllocTracker::start();
+ * {
+ *     AllocScope scope(ALLOC_DETECT_FACES);
+ *     ... // allocations of this thread go to detect_faces
+ * }
+ * AllocSnapshot snapshot = AllocTracker::snapshot();
+ */
+class AllocTracker
+{
+public:
+    // whether the global operator new / delete are replaced in this build
+    static bool compiledIn();
+
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // start counting
+    static void start();
+
+    static AllocSnapshot snapshot();
+
+    /**
+     * @brief setThreadTag set the tag of the calling thread
+     * @param tag
+     * @return the previous tag
+     */
+    static AllocTag setThreadTag(AllocTag tag);
+
+    /**
+     * @brief printReport print the counts per tag since start, per frame, and the peak RSS
+     * @param out
+     * @param frames frames processed since start
+     * @param since if not null, counts are also given since this snapshot (steady state)
+     * @param framesSince frames processed since this snapshot
+     */
+    static void printReport(std::ostream& out, long frames, const AllocSnapshot* since = nullptr, long framesSince = 0);
+
+    // called by the operators
+    static void recordAllocation(size_t size);
+    static void recordFree();
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+/**
+ * @brief The AllocScope class tags the allocations of the calling thread, from its construction to its destruction
+ */
+class AllocScope
+{
+public:
+    AllocScope(AllocTag tag) : m_previous(AllocTracker::setThreadTag(tag)) {}
+    AllocScope(const AllocScope&) = delete;
+
+    ~AllocScope() { AllocTracker::setThreadTag(m_previous); }
+
+private:
+    const AllocTag m_previous;
+};
+
+#endif // ALLOCTRACKER_H
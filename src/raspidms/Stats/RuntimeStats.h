@@ -0,0 +1,51 @@
+#ifndef RUNTIMESTATS_H
+#define RUNTIMESTATS_H
+
+#include <atomic>
+
+#include "FaceResults.h"
+
+/**
+ * @brief The RuntimeStats struct holds the counters of the capture loop, as atomics,
+ * so that they can be read from another thread (StatsServer) without any lock.
+ * Written by the capture loop only.
+ */
+struct RuntimeStats {
+    std::atomic<long> capturedFrames;
+    std::atomic<long> droppedInputFrames;   // dropped from inputFrameQueue, before any stage saw them
+    std::atomic<long> outputFrames;         // complete results out of the pipeline
+
+    // exponential moving averages, in seconds
+    std::atomic<float> stageLatencies[NUM_STAGES];
+    std::atomic<float> captureToOutputLatency;
+
+    RuntimeStats()
+        : capturedFrames(0), droppedInputFrames(0), outputFrames(0), captureToOutputLatency(0.f)
+    {
+        for (int stage = 0; stage < NUM_STAGES; ++stage)
+            stageLatencies[stage].store(0.f, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief recordResults account for new complete results, the stages they went through, and their latency
+     * @param faces
+     * @param latency capture to now, in seconds
+     */
+    void recordResults(const FaceResults& faces, double latency) {
+        for (int stage = 0; stage < NUM_STAGES; ++stage) {
+            if (faces.stageTimings[stage].threadId != -1)
+                average(stageLatencies[stage], faces.stageTimings[stage].duration);
+        }
+        outputFrames.fetch_add(1, std::memory_order_relaxed);
+        average(captureToOutputLatency, static_cast<float>(latency));
+    }
+
+private:
+    static void average(std::atomic<float>& average, float value) {
+        const float alpha = 0.1f;
+        const float previous = average.load(std::memory_order_relaxed);
+        average.store(previous == 0.f ? value : alpha * value + (1.f - alpha) * previous, std::memory_order_relaxed);
+    }
+};
+
+#endif // RUNTIMESTATS_H
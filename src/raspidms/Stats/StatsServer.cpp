@@ -0,0 +1,165 @@
+#include "Stats/StatsServer.h"
+
+#include "Tracing/Tracer.h"
+#include "Utils.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// how often the server thread checks for stop, and how long a client has to send its request
+const int POLL_TIMEOUT_MS = 200;
+
+// rates are computed over this period, in seconds
+const double RATE_PERIOD = 1.;
+
+StatsServer::StatsServer(const std::string& path, Pipeline& pipeline, const RuntimeStats& stats, Scheduler* scheduler)
+    : m_path(path),
+      m_pipeline(pipeline),
+      m_stats(stats),
+      m_scheduler(scheduler),
+      m_startTime(timeNow()),
+      m_previous(),
+      m_captureFps(0.),
+      m_detectFps(0.),
+      m_outputFps(0.),
+      m_socket(-1),
+      m_stop(false),
+      m_thread()
+{
+    struct sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "StatsServer: socket path too long " << path << std::endl;
+        return;
+    }
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    m_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_socket < 0) {
+        std::cerr << "StatsServer: can't create socket" << std::endl;
+        return;
+    }
+
+    unlink(path.c_str());
+    if (bind(m_socket, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0
+            || listen(m_socket, 4) != 0) {
+        std::cerr << "StatsServer: can't listen on " << path << std::endl;
+        close(m_socket);
+        m_socket = -1;
+        return;
+    }
+
+    m_previous = counters();
+    m_thread = std::thread(&StatsServer::run, this);
+}
+
+StatsServer::~StatsServer() {
+    if (m_socket < 0)
+        return;
+
+    m_stop = true;
+    m_thread.join();
+    close(m_socket);
+    unlink(m_path.c_str());
+}
+
+StatsServer::Counters StatsServer::counters() const {
+    return {timeNow(),
+            m_stats.capturedFrames.load(std::memory_order_relaxed),
+            m_pipeline.detectFacesStage.detectedFrames(),
+            m_stats.outputFrames.load(std::memory_order_relaxed)};
+}
+
+void StatsServer::run() {
+    Tracer::instance().setThreadName("stats server");
+
+    while (!m_stop) {
+        const Counters now = counters();
+        const double elapsed = now.time - m_previous.time;
+        if (elapsed >= RATE_PERIOD) {
+            m_captureFps = (now.captured - m_previous.captured) / elapsed;
+            m_detectFps = (now.detected - m_previous.detected) / elapsed;
+            m_outputFps = (now.output - m_previous.output) / elapsed;
+            m_previous = now;
+        }
+
+        struct pollfd listening = {m_socket, POLLIN, 0};
+        if (poll(&listening, 1, POLL_TIMEOUT_MS) <= 0)
+            continue;
+
+        const int client = accept(m_socket, nullptr, nullptr);
+        if (client < 0)
+            continue;
+
+        // the request is optional : wait a little for it
+        char request[16] = {0};
+        struct pollfd readable = {client, POLLIN, 0};
+        if (poll(&readable, 1, POLL_TIMEOUT_MS) > 0)
+            (void)!read(client, request, sizeof(request) - 1);
+        const bool json = std::strncmp(request, "text", 4) != 0;
+
+        const std::string response = snapshot(json);
+        size_t written = 0;
+        while (written < response.size()) {
+            const ssize_t n = send(client, response.data() + written, response.size() - written, MSG_NOSIGNAL);
+            if (n <= 0)
+                break;
+            written += n;
+        }
+        close(client);
+    }
+}
+
+std::string StatsServer::snapshot(bool json) const {
+    const Counters now = counters();
+    const long input_dropped = m_stats.droppedInputFrames.load(std::memory_order_relaxed);
+    // captured but never detected (dropped from the input queue, or skipped by a detection)
+    const long dropped = std::max(0L, now.captured - now.detected);
+    const size_t input_queue = m_pipeline.inputFrameQueue->size_no_lock();
+    const size_t rects_queue = m_pipeline.rectsQueue->size_no_lock();
+    const size_t face_features_queue = m_pipeline.faceFeaturesQueue->size_no_lock();
+    const int threads = m_scheduler ? m_scheduler->threadCount() : 0;
+    const int idle = m_scheduler ? m_scheduler->idleThreads() : 0;
+    const double latency_ms = m_stats.captureToOutputLatency.load(std::memory_order_relaxed) * 1000.;
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    if (json) {
+        out << "{\"uptime_s\":" << now.time - m_startTime
+            << ",\"fps\":{\"capture\":" << m_captureFps << ",\"detect\":" << m_detectFps << ",\"output\":" << m_outputFps << "}"
+            << ",\"frames\":{\"captured\":" << now.captured << ",\"detected\":" << now.detected
+            << ",\"output\":" << now.output << ",\"dropped\":" << dropped << ",\"input_dropped\":" << input_dropped << "}"
+            << ",\"queues\":{\"input\":" << input_queue << ",\"rects\":" << rects_queue
+            << ",\"face_features\":" << face_features_queue << "}"
+            << ",\"stage_latency_ms\":{";
+        for (int stage = 0; stage < NUM_STAGES; ++stage) {
+            out << (stage > 0 ? "," : "") << "\"" << stageName(static_cast<StageId>(stage)) << "\":"
+                << m_stats.stageLatencies[stage].load(std::memory_order_relaxed) * 1000.;
+        }
+        out << "},\"latency_ms\":" << latency_ms
+            << ",\"thread_pool\":{\"threads\":" << threads << ",\"idle\":" << idle << "}}\n";
+    } else {
+        out << "uptime_s " << now.time - m_startTime << "\n"
+            << "fps capture " << m_captureFps << " detect " << m_detectFps << " output " << m_outputFps << "\n"
+            << "frames captured " << now.captured << " detected " << now.detected << " output " << now.output
+            << " dropped " << dropped << " input_dropped " << input_dropped << "\n"
+            << "queues input " << input_queue << " rects " << rects_queue << " face_features " << face_features_queue << "\n"
+            << "stage_latency_ms";
+        for (int stage = 0; stage < NUM_STAGES; ++stage) {
+            out << " " << stageName(static_cast<StageId>(stage)) << " "
+                << m_stats.stageLatencies[stage].load(std::memory_order_relaxed) * 1000.;
+        }
+        out << "\n"
+            << "latency_ms " << latency_ms << "\n"
+            << "thread_pool threads " << threads << " idle " << idle << "\n";
+    }
+    return out.str();
+}
@@ -0,0 +1,69 @@
+#ifndef STATSSERVER_H
+#define STATSSERVER_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "Pipeline.h"
+#include "Scheduler.h"
+#include "Stats/RuntimeStats.h"
+
+/**
+ * @brief The StatsServer class serves a snapshot of the runtime statistics on a Unix domain socket, on its own thread :
+ * frame rates, frame counts (captured, detected, dropped, output), queue depths, average stage latencies
+ * and idle threads of the pool.
+ *
+ * A client connects, optionally sends "text" (JSON otherwise), and reads the snapshot until the socket is closed :
+ * echo text | nc -U /tmp/raspidms.sock
+ *
+ * Everything is read from atomics (RuntimeStats, SharedQueue::size_no_lock ...) : serving a snapshot never takes
+ * a lock of the pipeline. Rates are computed over the last second.
+ */
+class StatsServer
+{
+public:
+    /**
+     * @param path of the socket, replaced if it exists
+     * @param pipeline
+     * @param stats
+     * @param scheduler null if the stages run on the capture thread
+     */
+    StatsServer(const std::string& path, Pipeline& pipeline, const RuntimeStats& stats, Scheduler* scheduler);
+    StatsServer(const StatsServer&) = delete;
+
+    // stops the thread and removes the socket
+    ~StatsServer();
+
+    bool isOpened() const { return m_socket >= 0; }
+
+private:
+    struct Counters {
+        double time;
+        long captured;
+        long detected;
+        long output;
+    };
+
+    void run();
+    Counters counters() const;
+    std::string snapshot(bool json) const;
+
+    const std::string m_path;
+    Pipeline& m_pipeline;
+    const RuntimeStats& m_stats;
+    Scheduler* const m_scheduler;
+    const double m_startTime;
+
+    // only used by the server thread
+    Counters m_previous;
+    double m_captureFps;
+    double m_detectFps;
+    double m_outputFps;
+
+    int m_socket;
+    std::atomic<bool> m_stop;
+    std::thread m_thread;
+};
+
+#endif // STATSSERVER_H
@@ -9,6 +9,8 @@
 #include <thread>
 #include <vector>
 #include "SharedQueue.h"
+#include "Stats/AllocTracker.h"
+#include "Tracing/Tracer.h"
 #include "Utils.h"
 
 // Original inspiration from https://github.com/progschj/ThreadPool/blob/master/ThreadPool.h
@@ -40,6 +42,13 @@
  * This callback will be called back :
  * param long : the funcId of a function that was just ran
  * param double : the time in seconds it took to run the said function
+ *
+ * set_retired_callback(callback) with callback of signature std::function<void(int)> :
+ * called by a thread with its id when it is told to stop (resize down, stop), after its last function,
+ * useful to free the resources of this thread id
+ *
+ * Threads removed by a resize down finish their function on their own : they are joined once done
+ * (by a later resize), and at the latest by stop(), so that none outlives the pool.
  */
 
 const double MINIMAL_TIME_GRANULARITY = 0.01;
@@ -86,26 +95,35 @@ public:
                 m_threads.resize(nThreads);
                 m_flags.resize(nThreads);
 
+                m_exited.resize(nThreads);
+
                 for (int i = oldNThreads; i < nThreads; ++i) {
                     m_flags[i] = std::make_shared<std::atomic<bool>>(false);
+                    m_exited[i] = std::make_shared<std::atomic<bool>>(false);
                     set_thread(i);
                 }
             } else {  // the number of threads is decreased
                 for (int i = oldNThreads - 1; i >= nThreads; --i) {
                     *m_flags[i] = true;  // this thread will finish
-                    m_threads[i]->detach();
+                    m_retired.push_back({std::move(m_threads[i]), m_exited[i]});
                 }
                 {
-                    // stop the detached threads that were waiting
+                    // stop the retired threads that were waiting
                     std::unique_lock<std::mutex> lock(m_mutex);
                     m_cv.notify_all();
                 }
-                m_threads.resize(nThreads);  // safe to delete because the threads are detached
+                m_threads.resize(nThreads);  // safe to delete because the retired threads were moved out
                 m_flags.resize(nThreads);  // safe to delete because the threads have copies of shared_ptr of the flags, not originals
+                m_exited.resize(nThreads);
             }
+            join_retired(false);
         }
     }
 
+    // called by each thread told to stop (see set_retired_callback in the class description)
+    // must be set before any resize down or stop
+    void set_retired_callback(std::function<void(int)> retiredCb) { m_retiredCb = retiredCb; }
+
     // empty the queue
     void clear_queue() {
         FuncPack _f;
@@ -150,11 +168,13 @@ public:
             if (m_threads[i]->joinable())
                 m_threads[i]->join();
         }
+        join_retired(true);  // and for the retired ones still finishing their function
         // if there were no threads in the pool but some functors in the queue, the functors are not deleted by the threads
         // therefore delete them here
         clear_queue();
         m_threads.clear();
         m_flags.clear();
+        m_exited.clear();
     }
 
     template<typename F, typename... Rest>
@@ -194,10 +214,39 @@ private:
     ThreadPool & operator=(const ThreadPool &);// = delete;
     ThreadPool & operator=(ThreadPool &&);// = delete;
 
+    struct RetiredThread {
+        std::unique_ptr<std::thread> thread;
+        std::shared_ptr<std::atomic<bool>> exited;
+    };
+
+    // marks the thread function as returned, whatever the return path
+    struct ExitMark {
+        std::atomic<bool> & exited;
+        ~ExitMark() { exited = true; }
+    };
+
+    // join the retired threads whose function returned, or all of them if isAll
+    void join_retired(bool isAll) {
+        for (auto it = m_retired.begin(); it != m_retired.end();) {
+            if (isAll || *it->exited) {
+                if (it->thread->joinable())
+                    it->thread->join();
+                it = m_retired.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
     void set_thread(int i) {
         std::shared_ptr<std::atomic<bool>> flag(m_flags[i]); // a copy of the shared ptr to the flag
-        auto f = [this, i, flag/* a copy of the shared ptr to the flag */]() {
+        std::shared_ptr<std::atomic<bool>> exited(m_exited[i]);
+        auto f = [this, i, flag/* a copy of the shared ptr to the flag */, exited]() {
+            ExitMark exitMark{*exited};
             std::atomic<bool> & _flag = *flag;
+            Tracer::instance().setThreadName("pool worker " + std::to_string(i));
+            // allocations of the tasks are tagged by the tasks themselves
+            AllocTracker::setThreadTag(ALLOC_SCHEDULER);
             FuncPack _f;
             bool isPop = m_queue.pop_front_no_wait(_f);
             while (true) {
@@ -208,15 +257,21 @@ private:
                     double mark = timeMark(_f.id, false);
 
                     // call the actual function
-                    (*_f.funcPtr)(i);
                     {
+                        TRACE_SPAN("task");
+                        (*_f.funcPtr)(i);
+                    }
+                    if (m_timingCb) {
                         std::unique_lock<std::mutex> lock(m_mutex);
                         m_timingCb(_f.id, timeMark(_f.id, false) - mark + MINIMAL_TIME_GRANULARITY);
                     }
 
-                    if (_flag)
-                        return;  // the thread is to be stopped, return even if the queue is not empty yet
-                    else
+                    if (_flag) {
+                        // the thread is to be stopped, return even if the queue is not empty yet
+                        if (m_retiredCb)
+                            m_retiredCb(i);
+                        return;
+                    } else
                         isPop = m_queue.pop_front_no_wait(_f);
                 }
                 // the queue is empty here, wait for the next command
@@ -224,8 +279,13 @@ private:
                 ++m_nWaiting;
                 m_cv.wait(lock, [this, &_f, &isPop, &_flag](){ isPop = m_queue.pop_front_no_wait(_f); return isPop || m_isDone || _flag; });
                 --m_nWaiting;
-                if (!isPop)
-                    return;  // if the queue is empty and isDone == true or *flag then return
+                if (!isPop) {
+                    // if the queue is empty and isDone == true or *flag then return
+                    lock.unlock();
+                    if (_flag && m_retiredCb)
+                        m_retiredCb(i);
+                    return;
+                }
             }
         };
         m_threads[i].reset(new std::thread(f));
@@ -240,8 +300,11 @@ private:
 
     std::vector<std::unique_ptr<std::thread>> m_threads;
     std::vector<std::shared_ptr<std::atomic<bool>>> m_flags;
+    std::vector<std::shared_ptr<std::atomic<bool>>> m_exited;  // set by each thread when its function returns
+    std::vector<RetiredThread> m_retired;  // removed by a resize down, not joined yet
     SharedQueue<FuncPack> m_queue;
     std::function<void(long/*id*/, double/*time*/)> m_timingCb;
+    std::function<void(int/*thread id*/)> m_retiredCb;
     std::atomic<bool> m_isDone;
     std::atomic<bool> m_isStop;
     std::atomic<int> m_nWaiting;  // how many threads are waiting
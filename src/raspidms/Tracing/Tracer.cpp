@@ -0,0 +1,114 @@
+#include "Tracing/Tracer.h"
+
+#include "Utils.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+std::atomic<bool> Tracer::s_enabled(false);
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer()
+    : m_eventsPerThread(0),
+      m_startTime(0.),
+      m_buffers(),
+      m_mutex()
+{
+
+}
+
+void Tracer::start(size_t eventsPerThread) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (s_enabled.load(std::memory_order_relaxed))
+        return;
+
+    m_eventsPerThread = eventsPerThread;
+    m_startTime = timeNow();
+    s_enabled.store(true, std::memory_order_release);
+}
+
+Tracer::ThreadBuffer* Tracer::threadBuffer() {
+    // buffers are owned by the tracer, they outlive their thread
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer)
+        return buffer;
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    std::unique_ptr<ThreadBuffer> created(new ThreadBuffer());
+    created->events.reset(new Event[m_eventsPerThread]);
+    created->capacity = m_eventsPerThread;
+    created->size.store(0, std::memory_order_relaxed);
+    created->dropped.store(0, std::memory_order_relaxed);
+    created->tid = static_cast<int>(m_buffers.size()) + 1;
+    buffer = created.get();
+    m_buffers.push_back(std::move(created));
+    return buffer;
+}
+
+void Tracer::record(const char* name, double begin, double end) {
+    ThreadBuffer* buffer = threadBuffer();
+
+    // only this thread writes to its buffer
+    const size_t size = buffer->size.load(std::memory_order_relaxed);
+    if (size >= buffer->capacity) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer->events[size] = {name, begin, end};
+    buffer->size.store(size + 1, std::memory_order_release);
+}
+
+void Tracer::setThreadName(const std::string& name) {
+    if (!enabled())
+        return;
+
+    ThreadBuffer* buffer = threadBuffer();
+    std::lock_guard<std::mutex> guard(m_mutex);
+    buffer->name = name;
+}
+
+bool Tracer::writeChromeTrace(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Tracer: can't write " << path << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    size_t dropped = 0;
+
+    // timestamps and durations in microseconds
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"raspidms\"}}";
+    for (const auto& buffer : m_buffers) {
+        const std::string name = buffer->name.empty() ? "thread " + std::to_string(buffer->tid) : buffer->name;
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+             << ",\"args\":{\"name\":\"" << name << "\"}}";
+
+        const size_t size = buffer->size.load(std::memory_order_acquire);
+        for (size_t i = 0; i < size; ++i) {
+            const Event& event = buffer->events[i];
+            file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                 << ",\"ts\":" << (event.begin - m_startTime) * 1e6
+                 << ",\"dur\":" << (event.end - event.begin) * 1e6 << "}";
+        }
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    file << "\n]}\n";
+
+    if (dropped > 0)
+        std::cerr << "Tracer: " << dropped << " spans dropped, buffers were full" << std::endl;
+
+    return static_cast<bool>(file);
+}
+
+double TraceSpan::now() {
+    return timeNow();
+}
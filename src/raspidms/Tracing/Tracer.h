@@ -0,0 +1,119 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The Tracer class records spans (a name, a begin and an end time) of what each thread does,
+ * to be exported as a Chrome trace (JSON), loadable in Perfetto (ui.perfetto.dev) or chrome://tracing.
+ *
+ * Tracing is off until start() : spans then only cost a relaxed atomic load.
+ * Once started, each thread writes its spans to its own fixed capacity buffer, without lock
+ * (only its first span registers the buffer, under a mutex). Spans past the capacity are dropped.
+ * Span names must be string literals (or outlive the tracer).
+ *
+ * USAGE :
+ * Tracer::instance().start();
+ * {
+ *     TRACE_SPAN("detect_faces");
+ *     ...
+ * }
+ * Tracer::instance().writeChromeTrace("trace.json");
+ */
+class Tracer
+{
+public:
+    static Tracer& instance();
+
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief start enable tracing, only the first call has an effect
+     * @param eventsPerThread capacity of each thread buffer
+     */
+    void start(size_t eventsPerThread);
+
+    /**
+     * @brief record a span of the calling thread
+     * @param name
+     * @param begin seconds, see timeNow()
+     * @param end seconds
+     */
+    void record(const char* name, double begin, double end);
+
+    /**
+     * @brief setThreadName name the calling thread in the trace
+     * @param name
+     */
+    void setThreadName(const std::string& name);
+
+    /**
+     * @brief writeChromeTrace write the spans recorded so far, may be called while threads still record
+     * @param path
+     * @return false if the file can't be written
+     */
+    bool writeChromeTrace(const std::string& path);
+
+private:
+    struct Event {
+        const char* name;
+        double begin;
+        double end;
+    };
+
+    struct ThreadBuffer {
+        std::unique_ptr<Event[]> events;
+        size_t capacity;
+        std::atomic<size_t> size;     // events written so far, published with release
+        std::atomic<size_t> dropped;
+        int tid;
+        std::string name;             // guarded by Tracer::m_mutex
+    };
+
+    Tracer();
+    Tracer(const Tracer&) = delete;
+
+    ThreadBuffer* threadBuffer();
+
+    static std::atomic<bool> s_enabled;
+
+    size_t m_eventsPerThread;
+    double m_startTime;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    std::mutex m_mutex;
+};
+
+/**
+ * @brief The TraceSpan class records a span from its construction to its destruction, when tracing is enabled
+ */
+class TraceSpan
+{
+public:
+    TraceSpan(const char* name)
+        : m_name(Tracer::enabled() ? name : nullptr), m_begin(m_name ? now() : 0.) {}
+    TraceSpan(const TraceSpan&) = delete;
+
+    ~TraceSpan() {
+        if (m_name)
+            Tracer::instance().record(m_name, m_begin, now());
+    }
+
+private:
+    static double now();
+
+    const char* const m_name;
+    const double m_begin;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+// span of the enclosing scope
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name)
+
+#endif // TRACER_H
@@ -3,10 +3,13 @@
 
 #include <opencv2/opencv.hpp>
 
-#include <dlib/geometry/rectangle.h>
+#include <sys/resource.h>
+#include <time.h>
 
+#include <algorithm>
 #include <map>
 #include <mutex>
+#include <vector>
 /**
  * @brief timeMark
  * @param id
@@ -33,32 +36,40 @@ inline double timeMark(long id=0, bool update=true) {
 }
 
 /**
- * @brief getUniqueId
- * @return a unique id each time it is called (increment), useful to call timeMark later on
+ * @brief timeNow
+ * @return monotonic time in seconds, in the same time base as timeMark
  */
-inline long getUniqueId() {
-    static long t = 0;
-    return t++;
+inline double timeNow() {
+    return static_cast<double>(cv::getTickCount()) / cv::getTickFrequency();
+}
+
+/**
+ * @brief threadCpuTime
+ * @return CPU time in seconds used by the calling thread so far
+ */
+inline double threadCpuTime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
 }
 
 /**
- * @brief dlibRectangleToOpenCV
- * @param r dlib rectangle
- * @return an OpenCV rectangle converted from the dlib rectangle passed as param
+ * @brief peakRssKb
+ * @return peak resident set size of the process so far, in KB
  */
-inline cv::Rect dlibRectangleToOpenCV(const dlib::rectangle & r)
-{
-    return cv::Rect(cv::Point2f(r.left(), r.top()), cv::Point2f(r.right() + 1, r.bottom() + 1));
+inline long peakRssKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
 }
 
 /**
- * @brief openCVRectangleToDlib
- * @param r OpenCV rectangle
- * @return an dlib rectangle converted from the OpenCV rectangle passed as param
+ * @brief getUniqueId
+ * @return a unique id each time it is called (increment), useful to call timeMark later on
  */
-inline dlib::rectangle openCVRectangleToDlib(const cv::Rect & r)
-{
-    return dlib::rectangle((long)r.tl().x, (long)r.tl().y, (long)r.br().x - 1, (long)r.br().y - 1);
+inline long getUniqueId() {
+    static long t = 0;
+    return t++;
 }
 
 /**
@@ -73,4 +84,55 @@ inline float iou_score(const cv::Rect& a, const cv::Rect& b) {
     return intersection_area / union_area;
 }
 
+/**
+ * @brief iou_score
+ * @param a
+ * @param b
+ * @return IoU score between two rectangles with sub-pixel coordinates (not rounded as with cv::Rect),
+ * 0.0 if both are empty
+ */
+inline float iou_score(const cv::Rect2f& a, const cv::Rect2f& b) {
+    const float intersection_area = (a & b).area();
+    const float union_area = a.area() + b.area() - intersection_area;
+    return union_area > 0.f ? intersection_area / union_area : 0.f;
+}
+
+/**
+ * @brief bestIouMatch
+ * @param boxes candidate boxes
+ * @param available which of the candidate boxes may be matched
+ * @param n number of candidates
+ * @param box box to match
+ * @param threshold minimal IoU for a match
+ * @return index of the available candidate overlapping the most with box, -1 if none is above threshold
+ */
+inline int bestIouMatch(const cv::Rect2f* boxes, const bool* available, int n, const cv::Rect2f& box, float threshold) {
+    int best = -1;
+    float best_iou = threshold;
+    for (int i = 0; i < n; ++i) {
+        if (!available[i])
+            continue;
+        const float iou = iou_score(boxes[i], box);
+        if (iou > best_iou) {
+            best_iou = iou;
+            best = i;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief percentile
+ * @param values samples, taken by copy as they get partially sorted
+ * @param p percentile in [0, 100]
+ * @return the nearest rank p-th percentile of values, 0 if there are none
+ */
+inline double percentile(std::vector<double> values, double p) {
+    if (values.empty())
+        return 0.;
+    const size_t rank = std::min(values.size() - 1, static_cast<size_t>(p / 100. * values.size()));
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
 #endif // UTILS_H
@@ -6,28 +6,66 @@
 #include <opencv2/dnn.hpp>
 #include <opencv2/core/utility.hpp>
 
+#include <csignal>
 #include <getopt.h>
 #include <iostream>
 #include <errno.h>
 #include <math.h>
+#include <stdio.h>
 #include <memory>
 #include <string>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <thread>
 #include <utility>
 #include <vector>
 
 #include "Utils.h"
 
-#include "DetectFaces/DetectFacesStage.h"
-#include "FaceFeatures/FaceFeaturesStage.h"
+#include "Alerts/AlertSinkStdout.h"
+#include "Batch/BatchRunner.h"
+#include "Capture/FrameRecorder.h"
+#include "Capture/ReplaySource.h"
+#include "Capture/VideoCaptureSource.h"
+#include "Display/Display.h"
+#include "Publish/ShmPublisher.h"
+#include "Quality/QualityController.h"
+#include "Stats/AllocTracker.h"
+#include "Stats/StatsServer.h"
+#include "Tracing/Tracer.h"
+
+#include "Pipeline.h"
 
 #include "ThreadPool.h"
 #include "SharedQueue.h"
 
 #include "Scheduler.h"
 
-const uint32_t MAX_IN_BUFFER_SIZE = 8;
+// number of frames kept by the frame log (~15 KB each)
+const uint32_t FRAME_LOG_CAPACITY = 2048;
+
+// maximum number of frames recorded (1 min at 30 fps)
+const uint32_t RECORD_CAPACITY = 1800;
+
+// batch mode : frames decoded ahead or being processed, per thread
+const int BATCH_FRAMES_IN_FLIGHT_PER_THREAD = 2;
+
+// display : preview size relative to the frames, and maximum frames shown per second
+const double PREVIEW_SCALE = 0.5;
+const double DISPLAY_MAX_FPS = 15.;
+
+// spans kept per thread when tracing (24 bytes each)
+const size_t TRACE_EVENTS_PER_THREAD = 1 << 17;
+
+// allocation report : frames after which the pipeline is considered in steady state
+const long ALLOC_WARMUP_FRAMES = 100;
+
+// headless mode : set by SIGINT / SIGTERM to leave the capture loop
+static volatile sig_atomic_t g_stop = 0;
+
+static void onStopSignal(int) {
+    g_stop = 1;
+}
 
 void printHelp () {
     std::cout << "USAGE: " << std::endl
@@ -35,9 +73,20 @@ void printHelp () {
     << "with OPTIONS being ([] are optionals, rest is mandatory. A|B means A or B) :" << std::endl
     << "    -d|--face-detector haar|mediapipe|resnetCaffe|yoloResnet18|yoloEffnetb0" << std::endl
     << "    -m|--face-mesh dlib_68|mediapipe" << std::endl
-    << "    [-j|--multithread]" << std::endl
+    << "    [-j|--multithread [-a|--auto-threads MIN:MAX]]" << std::endl
+    << "    [-b|--batch [-o|--output PATH_TO_RESULTS.csv]]" << std::endl
+    << "    [-H|--headless[=SHM_NAME]]" << std::endl
+    << "    [-p|--preview-scale SCALE]" << std::endl
+    << "    [-F|--display-fps FPS]" << std::endl
+    << "    [-l|--log PATH_TO_FRAME_LOG]" << std::endl
+    << "    [-r|--record PATH_TO_RECORDING]" << std::endl
+    << "    [-T|--trace PATH_TO_TRACE.json]" << std::endl
+    << "    [-S|--stats-socket PATH_TO_SOCKET]" << std::endl
+    << "    [-A|--alloc-report]" << std::endl
+    << "    [-Q|--target-fps FPS [-L|--quality-ladder PATH_TO_LADDER]]" << std::endl
+    << "    [-R|--replay-rate original|max|FPS]" << std::endl
     << "    [-h|--help]" << std::endl
-    << "    0|PATH_TO_VIDEO.mp4" << std::endl;
+    << "    0|PATH_TO_VIDEO.mp4|PATH_TO_RECORDING" << std::endl;
 }
 
 typedef std::function<std::pair<std::vector<cv::Rect>, double>(cv::Mat frame)> DetectFaceFunc;
@@ -46,13 +95,39 @@ struct Args {
     std::string video_path;
     std::string face_detector_model;
     std::string face_mesh_model;
+    std::string log_path;
+    std::string record_path;
+    std::string trace_path;
+    std::string stats_socket;
+    std::string replay_rate;
+    std::string output_path;
+    std::string shm_name;
+    std::string quality_ladder_path;
+    double target_fps;
+    int min_threads;
+    int max_threads;
+    double preview_scale;
+    double display_fps;
     bool multithread;
+    bool batch;
+    bool headless;
+    bool alloc_report;
 };
 
 struct Args parseArgs(int argc, char** argv) {
 
     struct Args args;
     args.multithread = false;
+    args.batch = false;
+    args.headless = false;
+    args.alloc_report = false;
+    args.target_fps = 0.;
+    args.min_threads = 0;
+    args.max_threads = 0;
+    args.shm_name = SHM_DEFAULT_NAME;
+    args.preview_scale = PREVIEW_SCALE;
+    args.display_fps = DISPLAY_MAX_FPS;
+    args.replay_rate = "original";
 
     //Specifying the expected options
     //The two options l and b expect numbers as argument
@@ -60,13 +135,27 @@ struct Args parseArgs(int argc, char** argv) {
     {"face-detector",  required_argument,  0,  'd' },
     {"face-mesh",      required_argument,  0,  'm' },
     {"multithread",    no_argument,        0,  'j' },
+    {"auto-threads",   required_argument,  0,  'a' },
+    {"batch",          no_argument,        0,  'b' },
+    {"output",         required_argument,  0,  'o' },
+    {"headless",       optional_argument,  0,  'H' },
+    {"preview-scale",  required_argument,  0,  'p' },
+    {"display-fps",    required_argument,  0,  'F' },
+    {"log",            required_argument,  0,  'l' },
+    {"record",         required_argument,  0,  'r' },
+    {"trace",          required_argument,  0,  'T' },
+    {"stats-socket",   required_argument,  0,  'S' },
+    {"alloc-report",   no_argument,        0,  'A' },
+    {"target-fps",     required_argument,  0,  'Q' },
+    {"quality-ladder", required_argument,  0,  'L' },
+    {"replay-rate",    required_argument,  0,  'R' },
     {"help",           no_argument,        0,  'h' },
     {0, 0, 0, 0},
     };
 
     char opt = 0;
     int long_index = 0;
-    while ((opt = getopt_long(argc, argv, "d:m:jh",
+    while ((opt = getopt_long(argc, argv, "d:m:ja:bo:H::p:F:l:r:T:S:AQ:L:R:h",
                               long_options, &long_index )) != -1) {
         switch (opt) {
             case 'd' :
@@ -78,6 +167,55 @@ struct Args parseArgs(int argc, char** argv) {
             case 'j':
                 args.multithread = true;
                 break;
+            case 'a':
+                if (sscanf(optarg, "%d:%d", &args.min_threads, &args.max_threads) != 2
+                        || args.min_threads < 1 || args.max_threads < args.min_threads
+                        || args.max_threads > MAX_STAGE_THREADS) {
+                    printHelp();
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'b':
+                args.batch = true;
+                break;
+            case 'H':
+                args.headless = true;
+                if (optarg)
+                    args.shm_name = std::string(optarg);
+                break;
+            case 'p':
+                args.preview_scale = atof(optarg);
+                break;
+            case 'F':
+                args.display_fps = atof(optarg);
+                break;
+            case 'o':
+                args.output_path = std::string(optarg);
+                break;
+            case 'l':
+                args.log_path = std::string(optarg);
+                break;
+            case 'T':
+                args.trace_path = std::string(optarg);
+                break;
+            case 'S':
+                args.stats_socket = std::string(optarg);
+                break;
+            case 'A':
+                args.alloc_report = true;
+                break;
+            case 'Q':
+                args.target_fps = atof(optarg);
+                break;
+            case 'L':
+                args.quality_ladder_path = std::string(optarg);
+                break;
+            case 'r':
+                args.record_path = std::string(optarg);
+                break;
+            case 'R':
+                args.replay_rate = std::string(optarg);
+                break;
             case 'h':
                 printHelp();
                 exit(EXIT_SUCCESS);
@@ -97,120 +235,320 @@ struct Args parseArgs(int argc, char** argv) {
     return args;
 }
 
+void printBatchHeader(FILE* out) {
+    fprintf(out, "frame_id,timestamp,num_faces,driver_valid,ear,mar,eyes_closed,perclos,yawns_per_minute,yaw,pitch,roll\n");
+}
+
+void printBatchResult(FILE* out, const FaceResults& faces) {
+    const DriverState& state = faces.driverState;
+    fprintf(out, "%ld,%g,%d,%d", faces.frame.id, faces.frame.timestamp, faces.numFaces, state.valid);
+    if (state.valid) {
+        fprintf(out, ",%g,%g,%d,%g,%g", state.eyeAspectRatio, state.mouthAspectRatio, state.eyesClosed,
+                state.perclos, state.yawnsPerMinute);
+    } else {
+        fprintf(out, ",,,,,");
+    }
+    if (state.valid && faces.hasHeadPose[state.face])
+        fprintf(out, ",%g,%g,%g", faces.headYaw[state.face], faces.headPitch[state.face], faces.headRoll[state.face]);
+    else
+        fprintf(out, ",,,");
+    fprintf(out, "\n");
+}
+
 int main(int argc, char**argv) {
     const struct Args args = parseArgs(argc, argv);
 
-    cv::VideoCapture cap;
+    // in batch mode, the results keep the standard output (unless written to a file),
+    // everything else printed to std::cout goes to the standard error
+    FILE* batch_output = nullptr;
+    if (args.batch) {
+        batch_output = args.output_path.empty() ? fdopen(dup(STDOUT_FILENO), "w")
+                                                : fopen(args.output_path.c_str(), "w");
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+        if (!batch_output) {
+            std::cerr << "Can't open " << (args.output_path.empty() ? "the standard output" : args.output_path) << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // before any thread is started, for all of them to be traced
+    if (!args.trace_path.empty()) {
+        Tracer::instance().start(TRACE_EVENTS_PER_THREAD);
+        Tracer::instance().setThreadName(args.batch ? "emit" : "capture");
+    }
 
-    if (!args.video_path.empty() && std::all_of(args.video_path.begin(), args.video_path.end(), ::isdigit)) {
-        cap.open(stoi(args.video_path));
+    // counting from the start, model loading included
+    if (args.alloc_report)
+        AllocTracker::start();
+
+    std::unique_ptr<IFrameSource> source;
+    if (ReplaySource::isRecording(args.video_path)) {
+        // in batch mode, as fast as possible, with the recorded timestamps
+        if (args.batch)
+            source.reset(new ReplaySource(args.video_path, ReplayMode::MaxSpeed, 0., true));
+        else if (args.replay_rate == "original")
+            source.reset(new ReplaySource(args.video_path, ReplayMode::OriginalTiming));
+        else if (args.replay_rate == "max")
+            source.reset(new ReplaySource(args.video_path, ReplayMode::MaxSpeed));
+        else
+            source.reset(new ReplaySource(args.video_path, ReplayMode::FixedRate, atof(args.replay_rate.c_str())));
     } else {
-        cap.open(args.video_path);
+        source.reset(new VideoCaptureSource(args.video_path, args.batch));
     }
 
-    if (! cap.isOpened()) {
+    if (! source->isOpened()) {
         std::cerr << "Can't open file " << args.video_path << std::endl;
+        return EXIT_FAILURE;
     }
 
-    std::cout << "Start grabbing" << std::endl;
-
-    // In queue of frames
-    std::shared_ptr<SharedQueue<cv::Mat>> inputFrameQueue(new SharedQueue<cv::Mat>());
-
-    // Out queue of rects to draw (and region of interests for feature detection)
-    std::shared_ptr<SharedQueue<PointsList>> rectsQueue(new SharedQueue<PointsList>());
+    std::unique_ptr<FrameRecorder> recorder;
+    if (!args.record_path.empty())
+        recorder.reset(new FrameRecorder(args.record_path, RECORD_CAPACITY));
 
-    // Face feature to be drawn
-    std::shared_ptr<SharedQueue<PointsList>> faceFeaturesQueue(new SharedQueue<PointsList>());
+    std::cout << "Start grabbing" << std::endl;
 
-    // Responsible of detecting faces, needs in frames, and ouputs out rectangles
-    DetectFacesStage detectFacesStage(args.face_detector_model, inputFrameQueue, rectsQueue);
+    // stages and queues (alerts, in batch mode, do not go to the results on std::cout),
+    // frame log if a log path was given
+    Pipeline pipeline(args.face_detector_model, args.face_mesh_model, args.log_path, FRAME_LOG_CAPACITY,
+                      std::make_shared<AlertSinkStdout>(args.batch ? std::cerr : std::cout));
+
+    if (args.batch) {
+        // every frame, in order, as fast as possible : no display, no drop
+        const int n_threads = std::min(MAX_STAGE_THREADS, std::max(1, static_cast<int>(std::thread::hardware_concurrency())));
+        BatchRunner runner(n_threads, BATCH_FRAMES_IN_FLIGHT_PER_THREAD * n_threads);
+        StageCpuTimes cpu_times;
+
+        // not a ThreadPool thread id
+        const int emit_thread_id = n_threads;
+
+        // every model loaded and warmed up before the first frame
+        std::vector<int> thread_ids;
+        for (int thread_id = 0; thread_id < n_threads; ++thread_id)
+            thread_ids.push_back(thread_id);
+        pipeline.preload(thread_ids, std::cerr);
+
+        printBatchHeader(batch_output);
+        const double start_time = timeNow();
+        const size_t n_frames = runner.run(*source,
+            [&](const Frame& frame, int threadId) {
+                FaceResultsPtr rects;
+                {
+                    ScopedCpuTime cpu_time(cpu_times, STAGE_DETECT_FACES);
+                    rects = pipeline.detectFacesStage.process(frame, threadId);
+                }
+                ScopedCpuTime cpu_time(cpu_times, STAGE_FACE_FEATURES);
+                return pipeline.faceFeaturesStage.process(frame, *rects, threadId);
+            },
+            [&](FaceResultsPtr faces) {
+                // stages keeping a state over time get one result at a time, in order
+                pipeline.rawFaceFeaturesQueue->push_back(std::move(faces));
+                {
+                    ScopedCpuTime cpu_time(cpu_times, STAGE_LANDMARKS_FILTER);
+                    pipeline.landmarksFilterStage(emit_thread_id);
+                }
+                {
+                    ScopedCpuTime cpu_time(cpu_times, STAGE_DRIVER_STATE);
+                    pipeline.driverStateStage(emit_thread_id);
+                }
+                {
+                    ScopedCpuTime cpu_time(cpu_times, STAGE_HEAD_POSE);
+                    pipeline.headPoseStage(emit_thread_id);
+                }
+                {
+                    ScopedCpuTime cpu_time(cpu_times, STAGE_PUPILS);
+                    pipeline.pupilsStage(emit_thread_id);
+                }
 
-    // Responsible for detecting face feature (landmarks)
-    FaceFeaturesStage faceFeaturesStage(args.face_mesh_model, inputFrameQueue, rectsQueue, faceFeaturesQueue);
+                // passed on by the AlertEngine thread
+                pipeline.alertsQueue->front_wait();
+                pipeline.frameLogStage(emit_thread_id);
+
+                FaceResultsPtr result;
+                if (pipeline.faceFeaturesQueue->pop_front_no_wait(result))
+                    printBatchResult(batch_output, *result);
+            });
+        const double elapsed = timeNow() - start_time;
+
+        pipeline.alertEngine.stop();
+        fclose(batch_output);
+        if (runner.failed()) {
+            std::cerr << "Batch: stopped after " << n_frames << " frames, a frame could not be processed" << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (!args.trace_path.empty())
+            Tracer::instance().writeChromeTrace(args.trace_path);
+
+        if (args.alloc_report)
+            AllocTracker::printReport(std::cerr, n_frames);
+
+        std::cerr << "Batch: " << n_frames << " frames in " << elapsed << " s, "
+                  << (elapsed > 0. ? n_frames / elapsed : 0.) << " fps, " << n_threads << " threads" << std::endl;
+        for (int stage = 0; stage < NUM_STAGES; ++stage) {
+            if (stage == STAGE_ALERTS)
+                continue;
+            const double cpu = cpu_times.seconds(static_cast<StageId>(stage));
+            std::cerr << "    " << stageName(static_cast<StageId>(stage)) << " CPU time " << cpu << " s, "
+                      << (n_frames > 0 ? cpu * 1000. / n_frames : 0.) << " ms/frame" << std::endl;
+        }
+        return 0;
+    }
 
     Scheduler scheduler;
 
     scheduler.addFunc([&](int threadId) {
-        detectFacesStage(threadId);
-        faceFeaturesStage(threadId);
+        pipeline.runStages(threadId);
+    });
+
+    // the detectors of retired threads are freed
+    scheduler.setThreadRetiredCb([&](int threadId) {
+        pipeline.releaseThread(threadId);
     });
 
-    PointsList rects;
-    PointsList face_features;
+    // pool resized from the input queue depth and the idle threads
+    if (args.max_threads > 0) {
+        scheduler.setAutoResize(args.min_threads, args.max_threads, [&]() {
+            return pipeline.inputFrameQueue->size_no_lock();
+        });
+    }
+
+    // every model loaded and warmed up before the first frame is captured
+    // (the pool threads, or the capture thread, see runStages calls below)
+    std::vector<int> thread_ids;
+    for (int thread_id = 0; thread_id < (args.multithread ? scheduler.threadCount() : 1); ++thread_id)
+        thread_ids.push_back(thread_id);
+    pipeline.preload(thread_ids, std::cout);
+
+    std::shared_ptr<const FaceResults> rects;
+    std::shared_ptr<const FaceResults> face_features;
+    long last_output_frame_id = -1;
+
+    // headless : no window, latest frame and results go to shared memory until SIGINT / SIGTERM
+    std::unique_ptr<ShmPublisher> publisher;
+    if (args.headless) {
+        publisher.reset(new ShmPublisher(args.shm_name));
+        std::signal(SIGINT, onStopSignal);
+        std::signal(SIGTERM, onStopSignal);
+    }
+
+    // live statistics, served on a Unix socket
+    RuntimeStats stats;
+    std::unique_ptr<StatsServer> stats_server;
+    if (!args.stats_socket.empty())
+        stats_server.reset(new StatsServer(args.stats_socket, pipeline, stats, args.multithread ? &scheduler : nullptr));
+
+    // quality stepped down and up to keep the target frame rate
+    std::unique_ptr<QualityController> quality_controller;
+    if (args.target_fps > 0.) {
+        std::vector<QualityLevel> ladder = QualityController::defaultLadder(args.face_detector_model);
+        if (!args.quality_ladder_path.empty() && !QualityController::readLadder(args.quality_ladder_path, ladder)) {
+            std::cerr << "Can't read quality ladder " << args.quality_ladder_path << std::endl;
+            return EXIT_FAILURE;
+        }
+        quality_controller.reset(new QualityController(pipeline, args.target_fps, ladder,
+                                                       args.multithread ? scheduler.threadCount() : 1, std::cout));
+    }
+
+    // window : drawn and shown on its own thread, which the capture loop never waits for
+    std::unique_ptr<Display> display;
+    if (!args.headless)
+        display.reset(new Display("Head", args.preview_scale, args.display_fps));
+
+    AllocSnapshot steady_allocations;
+    long steady_frame = -1;
+    AllocTracker::setThreadTag(ALLOC_MAIN_LOOP);
 
-    cv::namedWindow("Head", cv::WINDOW_AUTOSIZE);
-    cv::Mat frame;
     for(;;)
     {
-        if (cv::pollKey() >= 0) {
+        TRACE_SPAN("capture_iteration");
+        if (args.headless ? g_stop != 0 : display->quitRequested()) {
             break;
         }
 
         // lose frames if too slow
-        while (inputFrameQueue->size() > MAX_IN_BUFFER_SIZE)
-            inputFrameQueue->pop_front_no_wait();
+        while (pipeline.inputFrameQueue->size() > MAX_IN_BUFFER_SIZE) {
+            if (pipeline.inputFrameQueue->pop_front_no_wait())
+                stats.droppedInputFrames.fetch_add(1, std::memory_order_relaxed);
+        }
 
-        // wait for a new frame from camera and store it into 'frame'
-        cap.read(frame);
-        // check if we succeeded
-        if (frame.empty()) {
+        // wait for a new frame from camera
+        // (a new buffer each time, as previous frames may still be in use by the stages)
+        Frame captured;
+        bool read = false;
+        {
+            TRACE_SPAN("capture.read");
+            read = source->read(captured);
+        }
+        if (!read) {
             std::cerr << "ERROR! blank frame grabbed\n";
             break;
         }
 
-        //TODO consider no copy
-        inputFrameQueue->push_back(frame);
+        // recorded as captured
+        if (recorder)
+            recorder->record(captured);
+
+        pipeline.inputFrameQueue->push_back(captured);
+        const long captured_frames = stats.capturedFrames.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (args.alloc_report && captured_frames == ALLOC_WARMUP_FRAMES) {
+            steady_allocations = AllocTracker::snapshot();
+            steady_frame = captured_frames;
+        }
+
+        if (quality_controller)
+            quality_controller->update(captured_frames);
 
         if (args.multithread) {
             scheduler.schedule();
         } else {
-            detectFacesStage(0);
-            faceFeaturesStage(0);
+            pipeline.runStages(0);
         }
 
 
         // emptying down to most recent bounding box
-        PointsList bounding_boxes;
-        while (rectsQueue->size() > 1) {
-            rectsQueue->pop_front_no_wait(bounding_boxes);
+        FaceResultsPtr bounding_boxes;
+        while (pipeline.rectsQueue->size() > 1) {
+            pipeline.rectsQueue->pop_front_no_wait(bounding_boxes);
         }
 
-        if (rectsQueue->front_no_wait(bounding_boxes) && bounding_boxes.size() > 0) {
+        if (pipeline.rectsQueue->front_no_wait(bounding_boxes) && bounding_boxes->numFaces > 0) {
             rects = bounding_boxes;
         }
 
-        for(const auto & points : rects) {
-            if (points.size() > 1)
-                rectangle(frame, cv::Point(points[0].x, points[0].y),
-                        cv::Point(points[1].x, points[1].y),
-                        cv::Scalar(255, 0, 0),
-                        3, 8, 0);
-        }
-
         // emptying down to most recent face features
-        PointsList features;
-        while (faceFeaturesQueue->size() > 1) {
-            faceFeaturesQueue->pop_front_no_wait(features);
+        FaceResultsPtr features;
+        while (pipeline.faceFeaturesQueue->size() > 1) {
+            pipeline.faceFeaturesQueue->pop_front_no_wait(features);
         }
 
-        if (faceFeaturesQueue->front_no_wait(features)) {
-            if (features.size() > 0) {
-                face_features = features;
-            } else {
-                std::cout << "Empty face features ! This should not happen !" << std::endl;
+        if (pipeline.faceFeaturesQueue->front_no_wait(features)) {
+            // the front result stays in the queue until a newer one comes
+            if (features->frame.id != last_output_frame_id) {
+                last_output_frame_id = features->frame.id;
+                stats.recordResults(*features, timeNow() - features->frame.timestamp);
             }
+            // without landmarks when the driver is gone : nothing stale is drawn
+            face_features = features;
         }
 
-        if (face_features.size() > 0) {
-            for(const auto & vecpoints : face_features) {
-                for(const auto & point : vecpoints) {
-                    circle(frame, point, 2, cv::Scalar(0, 0, 255), cv::FILLED, cv::LINE_8);
-                }
-            }
+        if (publisher) {
+            // the frame as captured, nothing drawn on it
+            publisher->publish(captured, face_features.get());
+        } else {
+            display->show(captured, rects, face_features);
         }
+    }
 
-        cv::imshow("Head", frame);
+    stats_server.reset();
+    // no stage may run anymore when the alert engine is stopped (see AlertEngine::stop)
+    scheduler.stop();
+    pipeline.alertEngine.stop();
+    pipeline.alertEngine.printLatencyReport();
+    if (args.alloc_report) {
+        const long frames = stats.capturedFrames.load(std::memory_order_relaxed);
+        AllocTracker::printReport(std::cout, frames,
+                                  steady_frame >= 0 ? &steady_allocations : nullptr, frames - steady_frame);
     }
+    if (!args.trace_path.empty())
+        Tracer::instance().writeChromeTrace(args.trace_path);
     return 0;
 }
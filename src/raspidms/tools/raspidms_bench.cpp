@@ -0,0 +1,281 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "DetectFaces/DetectFacesStage.h"
+#include "FaceFeatures/FaceFeaturesStage.h"
+#include "PhaseTimings.h"
+#include "Utils.h"
+
+/**
+ * Benchmarks each face detector (IDetectFaces) and face mesh (IFaceFeatures) on an image
+ * and on synthetic frames at several resolutions.
+ * Each implementation runs in its own process, so that its peak RSS is its own : it is loaded,
+ * warmed up, then run repeatedly on each input.
+ * Face meshes are given one face, a box in the middle of the frame.
+ *
+ * One CSV line per implementation, input and phase (preprocess, inference, postprocess, total)
+ * is written to the standard output, in milliseconds. Everything else printed goes to the standard error.
+ */
+
+const char* const DETECTORS[] = {"haar", "hog", "resnetCaffe", "yoloResnet18", "yoloEffnetb0", "mediapipe"};
+const char* const FACE_MESHES[] = {"dlib_68", "mediapipe"};
+
+const cv::Size SYNTHETIC_SIZES[] = {{320, 240}, {640, 480}, {1280, 720}, {1920, 1080}};
+
+const int DEFAULT_ITERATIONS = 100;
+const int DEFAULT_WARMUP = 10;
+const std::string DEFAULT_IMAGE_PATH = "../res/lake.jpg";
+
+void printHelp() {
+    std::cerr << "USAGE: " << std::endl
+    << "raspidms_bench OPTIONS" << std::endl
+    << "with OPTIONS being ([] are optionals, rest is mandatory. A|B means A or B) :" << std::endl
+    << "    [-d|--face-detector NAME] (repeatable, all compiled in by default)" << std::endl
+    << "    [-m|--face-mesh NAME] (repeatable, all compiled in by default)" << std::endl
+    << "    [-n|--iterations N] (" << DEFAULT_ITERATIONS << " by default)" << std::endl
+    << "    [-w|--warmup N] (" << DEFAULT_WARMUP << " by default)" << std::endl
+    << "    [-i|--image PATH] (" << DEFAULT_IMAGE_PATH << " by default)" << std::endl
+    << "    [-h|--help]" << std::endl;
+}
+
+struct Args {
+    std::vector<std::string> detectors;
+    std::vector<std::string> face_meshes;
+    std::string image_path;
+    int iterations;
+    int warmup;
+};
+
+struct Args parseArgs(int argc, char** argv) {
+    struct Args args;
+    args.image_path = DEFAULT_IMAGE_PATH;
+    args.iterations = DEFAULT_ITERATIONS;
+    args.warmup = DEFAULT_WARMUP;
+
+    static struct option long_options[] = {
+    {"face-detector",  required_argument,  0,  'd' },
+    {"face-mesh",      required_argument,  0,  'm' },
+    {"iterations",     required_argument,  0,  'n' },
+    {"warmup",         required_argument,  0,  'w' },
+    {"image",          required_argument,  0,  'i' },
+    {"help",           no_argument,        0,  'h' },
+    {0, 0, 0, 0},
+    };
+
+    int opt = 0;
+    int long_index = 0;
+    while ((opt = getopt_long(argc, argv, "d:m:n:w:i:h", long_options, &long_index)) != -1) {
+        switch (opt) {
+            case 'd' :
+                args.detectors.push_back(optarg);
+                break;
+            case 'm' :
+                args.face_meshes.push_back(optarg);
+                break;
+            case 'n' :
+                args.iterations = std::max(1, atoi(optarg));
+                break;
+            case 'w' :
+                args.warmup = std::max(0, atoi(optarg));
+                break;
+            case 'i' :
+                args.image_path = optarg;
+                break;
+            case 'h':
+                printHelp();
+                exit(EXIT_SUCCESS);
+            default:
+                printHelp();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    // by default, every implementation compiled in (see BuildConfig.h)
+    if (args.detectors.empty() && args.face_meshes.empty()) {
+        for (const char* name : DETECTORS) {
+            if (DetectFacesStage::detectorFactory(name))
+                args.detectors.push_back(name);
+        }
+        for (const char* name : FACE_MESHES) {
+            if (FaceFeaturesStage::detectorFactory(name))
+                args.face_meshes.push_back(name);
+        }
+    }
+
+    return args;
+}
+
+struct Input {
+    std::string name;
+    cv::Mat image;
+};
+
+static std::vector<Input> makeInputs(const std::string& imagePath) {
+    std::vector<Input> inputs;
+
+    cv::Mat image = cv::imread(imagePath, cv::IMREAD_COLOR);
+    if (image.empty())
+        std::cerr << "Can't read " << imagePath << ", synthetic frames only" << std::endl;
+    else
+        inputs.push_back({imagePath, image});
+
+    // uniform noise, the same on every run
+    cv::RNG rng(0x5eed);
+    for (const cv::Size& size : SYNTHETIC_SIZES) {
+        cv::Mat frame(size, CV_8UC3);
+        rng.fill(frame, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+        std::ostringstream name;
+        name << "synthetic_" << size.width << "x" << size.height;
+        inputs.push_back({name.str(), frame});
+    }
+
+    return inputs;
+}
+
+// one face, in the middle of the frame, half its height
+static void setCenteredFace(FaceResults& faces, const cv::Mat& image) {
+    const float side = image.rows * 0.5f;
+    const cv::Point2f center(image.cols * 0.5f, image.rows * 0.5f);
+    faces.clear();
+    faces.addFace(center - cv::Point2f(side, side) * 0.5f, center + cv::Point2f(side, side) * 0.5f);
+}
+
+static void printHeader(FILE* table) {
+    fprintf(table, "kind,implementation,input,width,height,iterations,phase,min_ms,median_ms,p99_ms,peak_rss_kb\n");
+}
+
+static void printRows(FILE* table, const char* kind, const std::string& implementation, const Input& input,
+                      const std::vector<double> (&samples)[NUM_PHASES + 1]) {
+    const long rss = peakRssKb();
+    for (int phase = 0; phase <= NUM_PHASES; ++phase) {
+        const std::vector<double>& values = samples[phase];
+        const char* name = phase < NUM_PHASES ? phaseName(static_cast<InferencePhase>(phase)) : "total";
+        fprintf(table, "%s,%s,%s,%d,%d,%zu,%s,%.3f,%.3f,%.3f,%ld\n",
+                kind, implementation.c_str(), input.name.c_str(), input.image.cols, input.image.rows,
+                values.size(), name,
+                percentile(values, 0.) * 1000., percentile(values, 50.) * 1000., percentile(values, 99.) * 1000.,
+                rss);
+    }
+    fflush(table);
+}
+
+/**
+ * @brief benchmark run model on each input, warmup times then iterations times
+ * @param call runs the model once on an image, and returns its phase timings
+ */
+template <typename Call>
+static void benchmark(FILE* table, const char* kind, const std::string& implementation,
+                      const std::vector<Input>& inputs, const Args& args, Call call) {
+    for (const Input& input : inputs) {
+        for (int i = 0; i < args.warmup; ++i)
+            call(input.image);
+
+        std::vector<double> samples[NUM_PHASES + 1];
+        for (int i = 0; i < args.iterations; ++i) {
+            const double start = timeNow();
+            const PhaseTimings& timings = call(input.image);
+            const double total = timeNow() - start;
+
+            for (int phase = 0; phase < NUM_PHASES; ++phase)
+                samples[phase].push_back(timings.durations[phase]);
+            samples[NUM_PHASES].push_back(total);
+        }
+
+        printRows(table, kind, implementation, input, samples);
+    }
+}
+
+static int runDetector(FILE* table, const std::string& name, const Args& args) {
+    std::shared_ptr<IDetectFaces> detector = DetectFacesStage::createDetector(name);
+    if (!detector) {
+        std::cerr << "Unknown face detector " << name << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<Input> inputs = makeInputs(args.image_path);
+    FaceResults faces;
+    benchmark(table, "detector", name, inputs, args, [&](const cv::Mat& image) -> const PhaseTimings& {
+        faces.clear();
+        (*detector)(image, faces);
+        return detector->phaseTimings();
+    });
+    return EXIT_SUCCESS;
+}
+
+static int runFaceMesh(FILE* table, const std::string& name, const Args& args) {
+    std::shared_ptr<IFaceFeatures> faceFeatures = FaceFeaturesStage::createDetector(name);
+    if (!faceFeatures) {
+        std::cerr << "Unknown face mesh " << name << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<Input> inputs = makeInputs(args.image_path);
+    FaceResults faces;
+    benchmark(table, "face_mesh", name, inputs, args, [&](const cv::Mat& image) -> const PhaseTimings& {
+        setCenteredFace(faces, image);
+        (*faceFeatures)(image, faces);
+        return faceFeatures->phaseTimings();
+    });
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief runIsolated run func in a child process
+ * @return false if the child failed
+ */
+template <typename Func>
+static bool runIsolated(Func func) {
+    fflush(nullptr);
+    const pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "fork failed" << std::endl;
+        return false;
+    }
+    if (pid == 0) {
+        const int status = func();
+        fflush(nullptr);
+        _exit(status);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+    const struct Args args = parseArgs(argc, argv);
+
+    // the table keeps the standard output, models print their own messages to the standard error
+    FILE* table = fdopen(dup(STDOUT_FILENO), "w");
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    if (!table) {
+        std::cerr << "Can't open the standard output" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    printHeader(table);
+
+    bool ok = true;
+    for (const std::string& name : args.detectors) {
+        std::cerr << "Benchmarking face detector " << name << std::endl;
+        ok = runIsolated([&] { return runDetector(table, name, args); }) && ok;
+    }
+    for (const std::string& name : args.face_meshes) {
+        std::cerr << "Benchmarking face mesh " << name << std::endl;
+        ok = runIsolated([&] { return runFaceMesh(table, name, args); }) && ok;
+    }
+
+    fclose(table);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
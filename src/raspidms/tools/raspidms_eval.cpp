@@ -0,0 +1,303 @@
+#include <dirent.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "DetectFaces/DetectFacesStage.h"
+#include "Utils.h"
+
+/**
+ * Evaluates the accuracy and the speed of the face detectors on a directory of annotated images.
+ *
+ * Each image (.jpg, .jpeg, .png, .bmp) may come with an annotation file of the same name and a .txt extension,
+ * holding one face per line : "x y width height", in pixels. Empty lines and lines starting with # are ignored.
+ * An image without annotation file has no face.
+ *
+ * A detection matches the annotated face it overlaps the most, if their IoU is above the threshold,
+ * and each face matches at most one detection (best scores first). Detectors find at most MAX_FACES faces.
+ *
+ * One CSV line per detector is written to the standard output, sorted by mean latency, with pareto = 1
+ * for the detectors that no other one beats both in F1 score and in latency.
+ * Everything else printed goes to the standard error.
+ */
+
+const char* const DETECTORS[] = {"haar", "hog", "resnetCaffe", "yoloResnet18", "yoloEffnetb0", "mediapipe"};
+const char* const IMAGE_EXTENSIONS[] = {".jpg", ".jpeg", ".png", ".bmp"};
+
+const float DEFAULT_IOU_THRESHOLD = 0.5f;
+
+// calls on the first image before measuring
+const int WARMUP_CALLS = 5;
+
+void printHelp() {
+    std::cerr << "USAGE: " << std::endl
+    << "raspidms_eval OPTIONS" << std::endl
+    << "with OPTIONS being ([] are optionals, rest is mandatory. A|B means A or B) :" << std::endl
+    << "    [-d|--face-detector NAME] (repeatable, all compiled in by default)" << std::endl
+    << "    [-t|--iou-threshold IOU] (" << DEFAULT_IOU_THRESHOLD << " by default)" << std::endl
+    << "    [-h|--help]" << std::endl
+    << "    PATH_TO_ANNOTATED_IMAGES_DIRECTORY" << std::endl;
+}
+
+struct Args {
+    std::vector<std::string> detectors;
+    std::string directory;
+    float iou_threshold;
+};
+
+struct Args parseArgs(int argc, char** argv) {
+    struct Args args;
+    args.iou_threshold = DEFAULT_IOU_THRESHOLD;
+
+    static struct option long_options[] = {
+    {"face-detector",  required_argument,  0,  'd' },
+    {"iou-threshold",  required_argument,  0,  't' },
+    {"help",           no_argument,        0,  'h' },
+    {0, 0, 0, 0},
+    };
+
+    int opt = 0;
+    int long_index = 0;
+    while ((opt = getopt_long(argc, argv, "d:t:h", long_options, &long_index)) != -1) {
+        switch (opt) {
+            case 'd' :
+                args.detectors.push_back(optarg);
+                break;
+            case 't' :
+                args.iou_threshold = atof(optarg);
+                break;
+            case 'h':
+                printHelp();
+                exit(EXIT_SUCCESS);
+            default:
+                printHelp();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (optind < argc && argc - optind == 1) {
+        args.directory = argv[optind];
+    } else {
+        printHelp();
+        exit(EXIT_FAILURE);
+    }
+
+    // by default, every detector compiled in (see BuildConfig.h)
+    if (args.detectors.empty()) {
+        for (const char* name : DETECTORS) {
+            if (DetectFacesStage::detectorFactory(name))
+                args.detectors.push_back(name);
+        }
+    }
+
+    return args;
+}
+
+struct AnnotatedImage {
+    std::string path;
+    cv::Mat image;
+    std::vector<cv::Rect2f> faces;
+};
+
+static bool hasImageExtension(const std::string& name) {
+    const size_t dot = name.rfind('.');
+    if (dot == std::string::npos)
+        return false;
+    std::string extension = name.substr(dot);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return std::find(std::begin(IMAGE_EXTENSIONS), std::end(IMAGE_EXTENSIONS), extension) != std::end(IMAGE_EXTENSIONS);
+}
+
+static std::vector<cv::Rect2f> readAnnotations(const std::string& path) {
+    std::vector<cv::Rect2f> faces;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream values(line);
+        float x, y, width, height;
+        if (values >> x >> y >> width >> height)
+            faces.push_back(cv::Rect2f(x, y, width, height));
+        else
+            std::cerr << "Ignoring line \"" << line << "\" of " << path << std::endl;
+    }
+    return faces;
+}
+
+static std::vector<AnnotatedImage> loadDataset(const std::string& directory) {
+    std::vector<std::string> names;
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        std::cerr << "Can't open directory " << directory << std::endl;
+        return {};
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        if (hasImageExtension(entry->d_name))
+            names.push_back(entry->d_name);
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+
+    std::vector<AnnotatedImage> dataset;
+    for (const std::string& name : names) {
+        AnnotatedImage annotated;
+        annotated.path = directory + "/" + name;
+        annotated.image = cv::imread(annotated.path, cv::IMREAD_COLOR);
+        if (annotated.image.empty()) {
+            std::cerr << "Can't read " << annotated.path << std::endl;
+            continue;
+        }
+        annotated.faces = readAnnotations(annotated.path.substr(0, annotated.path.rfind('.')) + ".txt");
+        dataset.push_back(std::move(annotated));
+    }
+    return dataset;
+}
+
+struct Evaluation {
+    std::string detector;
+    long faces = 0;
+    long truePositives = 0;
+    long falsePositives = 0;
+    long falseNegatives = 0;
+    double iouSum = 0.;
+    std::vector<double> latencies;
+
+    double precision() const {
+        return truePositives + falsePositives > 0 ? static_cast<double>(truePositives) / (truePositives + falsePositives) : 0.;
+    }
+    double recall() const {
+        return faces > 0 ? static_cast<double>(truePositives) / faces : 0.;
+    }
+    double f1() const {
+        const double p = precision();
+        const double r = recall();
+        return p + r > 0. ? 2. * p * r / (p + r) : 0.;
+    }
+    double meanIou() const {
+        return truePositives > 0 ? iouSum / truePositives : 0.;
+    }
+    double meanLatency() const {
+        return latencies.empty() ? 0. : std::accumulate(latencies.begin(), latencies.end(), 0.) / latencies.size();
+    }
+};
+
+/**
+ * @brief match add the detections of an image to evaluation
+ * @param detections
+ * @param faces annotated faces
+ */
+static void match(const FaceResults& detections, const std::vector<cv::Rect2f>& faces,
+                  float iouThreshold, Evaluation& evaluation) {
+    std::unique_ptr<bool[]> available(new bool[faces.size() + 1]);
+    std::fill(available.get(), available.get() + faces.size(), true);
+
+    std::vector<int> order(detections.numFaces);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return detections.scores[a] > detections.scores[b]; });
+
+    for (int detection : order) {
+        const cv::Rect2f box = detections.box(detection);
+        const int face = bestIouMatch(faces.data(), available.get(), static_cast<int>(faces.size()), box, iouThreshold);
+        if (face < 0) {
+            ++evaluation.falsePositives;
+            continue;
+        }
+        available[face] = false;
+        ++evaluation.truePositives;
+        evaluation.iouSum += iou_score(faces[face], box);
+    }
+
+    evaluation.faces += faces.size();
+    evaluation.falseNegatives += std::count(available.get(), available.get() + faces.size(), true);
+}
+
+static bool evaluate(const std::string& name, const std::vector<AnnotatedImage>& dataset,
+                     float iouThreshold, Evaluation& evaluation) {
+    std::shared_ptr<IDetectFaces> detector = DetectFacesStage::createDetector(name);
+    if (!detector) {
+        std::cerr << "Unknown face detector " << name << std::endl;
+        return false;
+    }
+    std::cerr << "Evaluating " << name << " on " << dataset.size() << " images" << std::endl;
+
+    evaluation.detector = name;
+    FaceResults detections;
+    for (int i = 0; i < WARMUP_CALLS; ++i) {
+        detections.clear();
+        (*detector)(dataset.front().image, detections);
+    }
+
+    for (const AnnotatedImage& annotated : dataset) {
+        detections.clear();
+        const double start = timeNow();
+        (*detector)(annotated.image, detections);
+        evaluation.latencies.push_back(timeNow() - start);
+
+        match(detections, annotated.faces, iouThreshold, evaluation);
+    }
+    return true;
+}
+
+static void printTable(FILE* table, std::vector<Evaluation>& evaluations) {
+    std::sort(evaluations.begin(), evaluations.end(),
+              [](const Evaluation& a, const Evaluation& b) { return a.meanLatency() < b.meanLatency(); });
+
+    fprintf(table, "detector,images,faces,true_positives,false_positives,false_negatives,precision,recall,f1,mean_iou,"
+                   "latency_mean_ms,latency_p50_ms,latency_p99_ms,pareto\n");
+
+    // sorted by latency : on the Pareto front if more accurate than every faster detector
+    double best_f1 = -1.;
+    for (const Evaluation& evaluation : evaluations) {
+        const bool pareto = evaluation.f1() > best_f1;
+        best_f1 = std::max(best_f1, evaluation.f1());
+
+        fprintf(table, "%s,%zu,%ld,%ld,%ld,%ld,%.4f,%.4f,%.4f,%.4f,%.3f,%.3f,%.3f,%d\n",
+                evaluation.detector.c_str(), evaluation.latencies.size(), evaluation.faces,
+                evaluation.truePositives, evaluation.falsePositives, evaluation.falseNegatives,
+                evaluation.precision(), evaluation.recall(), evaluation.f1(), evaluation.meanIou(),
+                evaluation.meanLatency() * 1000., percentile(evaluation.latencies, 50.) * 1000.,
+                percentile(evaluation.latencies, 99.) * 1000., pareto ? 1 : 0);
+    }
+}
+
+int main(int argc, char** argv) {
+    const struct Args args = parseArgs(argc, argv);
+
+    // the table keeps the standard output, models print their own messages to the standard error
+    FILE* table = fdopen(dup(STDOUT_FILENO), "w");
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    if (!table) {
+        std::cerr << "Can't open the standard output" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<AnnotatedImage> dataset = loadDataset(args.directory);
+    if (dataset.empty()) {
+        std::cerr << "No image in " << args.directory << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Evaluation> evaluations;
+    for (const std::string& name : args.detectors) {
+        Evaluation evaluation;
+        if (evaluate(name, dataset, args.iou_threshold, evaluation))
+            evaluations.push_back(std::move(evaluation));
+    }
+
+    printTable(table, evaluations);
+    fclose(table);
+    return EXIT_SUCCESS;
+}
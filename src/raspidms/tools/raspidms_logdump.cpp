@@ -0,0 +1,219 @@
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Logging/FrameLogFormat.h"
+
+/**
+ * Dumps a frame log written by raspidms (-l option) to CSV or JSON lines, oldest record first
+ * CSV has one row per frame, with the boxes and head pose of each face but no landmarks
+ * JSON has one object per line and per frame, with the landmarks when -L is given
+ */
+
+void printHelp() {
+    std::cout << "USAGE: " << std::endl
+    << "raspidms_logdump OPTIONS" << std::endl
+    << "with OPTIONS being ([] are optionals, rest is mandatory. A|B means A or B) :" << std::endl
+    << "    [-f|--format csv|json]" << std::endl
+    << "    [-L|--landmarks]" << std::endl
+    << "    [-h|--help]" << std::endl
+    << "    PATH_TO_LOG" << std::endl;
+}
+
+struct Args {
+    std::string log_path;
+    bool json;
+    bool landmarks;
+};
+
+struct Args parseArgs(int argc, char** argv) {
+    struct Args args;
+    args.json = false;
+    args.landmarks = false;
+
+    static struct option long_options[] = {
+    {"format",     required_argument,  0,  'f' },
+    {"landmarks",  no_argument,        0,  'L' },
+    {"help",       no_argument,        0,  'h' },
+    {0, 0, 0, 0},
+    };
+
+    int opt = 0;
+    int long_index = 0;
+    while ((opt = getopt_long(argc, argv, "f:Lh", long_options, &long_index)) != -1) {
+        switch (opt) {
+            case 'f' :
+                args.json = std::string(optarg) == "json";
+                break;
+            case 'L' :
+                args.landmarks = true;
+                break;
+            case 'h':
+                printHelp();
+                exit(EXIT_SUCCESS);
+            default:
+                printHelp();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (optind < argc && argc - optind == 1) {
+        args.log_path = std::string(argv[argc - 1]);
+    } else {
+        printHelp();
+        exit(EXIT_FAILURE);
+    }
+
+    return args;
+}
+
+void printCsvHeader() {
+    std::cout << "sequence,frame_id,capture_ts,detection_ts,log_ts";
+    for (int stage = 0; stage < FRAME_LOG_NUM_STAGES; ++stage)
+        std::cout << "," << FRAME_LOG_STAGE_NAMES[stage] << "_ms," << FRAME_LOG_STAGE_NAMES[stage] << "_thread";
+    std::cout << ",num_faces,num_landmarks,driver_valid,driver_face,ear,mar,eyes_closed,yawning,perclos,yawns_per_minute";
+    for (int face = 0; face < FRAME_LOG_MAX_FACES; ++face) {
+        std::cout << ",face" << face << "_left,face" << face << "_top,face" << face << "_right,face" << face << "_bottom"
+                  << ",face" << face << "_score,face" << face << "_landmarks"
+                  << ",face" << face << "_yaw,face" << face << "_pitch,face" << face << "_roll";
+    }
+    std::cout << "\n";
+}
+
+void printCsv(const FrameLogRecord& record) {
+    std::cout << record.sequence.load() << "," << record.frameId << ","
+              << record.captureTimestamp << "," << record.detectionTimestamp << "," << record.logTimestamp;
+    for (int stage = 0; stage < FRAME_LOG_NUM_STAGES; ++stage)
+        std::cout << "," << record.stageTimings[stage].duration * 1000.f << "," << record.stageTimings[stage].threadId;
+    std::cout << "," << record.numFaces << "," << record.numLandmarks
+              << "," << int(record.driverValid) << "," << record.driverFace
+              << "," << record.eyeAspectRatio << "," << record.mouthAspectRatio
+              << "," << int(record.eyesClosed) << "," << int(record.yawning)
+              << "," << record.perclos << "," << record.yawnsPerMinute;
+    for (int face = 0; face < FRAME_LOG_MAX_FACES; ++face) {
+        if (face < record.numFaces) {
+            std::cout << "," << record.boxes[face][0] << "," << record.boxes[face][1]
+                      << "," << record.boxes[face][2] << "," << record.boxes[face][3]
+                      << "," << record.scores[face] << "," << int(record.hasLandmarks[face]);
+            if (record.hasHeadPose[face])
+                std::cout << "," << record.headPose[face][0] << "," << record.headPose[face][1] << "," << record.headPose[face][2];
+            else
+                std::cout << ",,,";
+        } else {
+            std::cout << ",,,,,,,,";
+        }
+    }
+    std::cout << "\n";
+}
+
+void printJson(const FrameLogRecord& record, bool landmarks) {
+    std::cout << "{\"sequence\":" << record.sequence.load()
+              << ",\"frame_id\":" << record.frameId
+              << ",\"capture_ts\":" << record.captureTimestamp
+              << ",\"detection_ts\":" << record.detectionTimestamp
+              << ",\"log_ts\":" << record.logTimestamp
+              << ",\"stages\":{";
+    for (int stage = 0; stage < FRAME_LOG_NUM_STAGES; ++stage) {
+        std::cout << (stage ? "," : "") << "\"" << FRAME_LOG_STAGE_NAMES[stage] << "\":{\"ms\":"
+                  << record.stageTimings[stage].duration * 1000.f
+                  << ",\"thread\":" << record.stageTimings[stage].threadId << "}";
+    }
+    std::cout << "}";
+
+    if (record.driverValid) {
+        std::cout << ",\"driver\":{\"face\":" << record.driverFace
+                  << ",\"ear\":" << record.eyeAspectRatio
+                  << ",\"mar\":" << record.mouthAspectRatio
+                  << ",\"eyes_closed\":" << (record.eyesClosed ? "true" : "false")
+                  << ",\"yawning\":" << (record.yawning ? "true" : "false")
+                  << ",\"perclos\":" << record.perclos
+                  << ",\"yawns_per_minute\":" << record.yawnsPerMinute << "}";
+    } else {
+        std::cout << ",\"driver\":null";
+    }
+
+    std::cout << ",\"faces\":[";
+    for (int face = 0; face < record.numFaces && face < FRAME_LOG_MAX_FACES; ++face) {
+        std::cout << (face ? "," : "") << "{\"box\":[" << record.boxes[face][0] << "," << record.boxes[face][1]
+                  << "," << record.boxes[face][2] << "," << record.boxes[face][3] << "]"
+                  << ",\"score\":" << record.scores[face];
+        if (record.hasHeadPose[face])
+            std::cout << ",\"head_pose\":[" << record.headPose[face][0] << "," << record.headPose[face][1]
+                      << "," << record.headPose[face][2] << "]";
+        if (landmarks && record.hasLandmarks[face]) {
+            std::cout << ",\"landmarks\":[";
+            for (int i = 0; i < record.numLandmarks && i < FRAME_LOG_MAX_LANDMARKS; ++i)
+                std::cout << (i ? "," : "") << "[" << record.landmarksX[face][i] << "," << record.landmarksY[face][i] << "]";
+            std::cout << "]";
+        }
+        std::cout << "}";
+    }
+    std::cout << "]}\n";
+}
+
+int main(int argc, char** argv) {
+    const struct Args args = parseArgs(argc, argv);
+
+    const int fd = open(args.log_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Can't open file " << args.log_path << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FrameLogHeader)) {
+        std::cerr << "Not a frame log " << args.log_path << std::endl;
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "Can't map file " << args.log_path << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const FrameLogHeader* header = static_cast<const FrameLogHeader*>(data);
+    if (std::memcmp(header->magic, FRAME_LOG_MAGIC, sizeof(FRAME_LOG_MAGIC)) != 0
+            || header->version != FRAME_LOG_VERSION
+            || header->headerSize != sizeof(FrameLogHeader)
+            || header->recordSize != sizeof(FrameLogRecord)
+            || sizeof(FrameLogHeader) + static_cast<size_t>(header->capacity) * sizeof(FrameLogRecord) > static_cast<size_t>(st.st_size)) {
+        std::cerr << "Unsupported frame log format " << args.log_path << std::endl;
+        munmap(data, st.st_size);
+        return EXIT_FAILURE;
+    }
+
+    const FrameLogRecord* records = reinterpret_cast<const FrameLogRecord*>(static_cast<const char*>(data) + sizeof(FrameLogHeader));
+
+    // valid records, oldest first
+    std::vector<std::pair<uint64_t, const FrameLogRecord*>> valid;
+    for (uint32_t slot = 0; slot < header->capacity; ++slot) {
+        const uint64_t sequence = records[slot].sequence.load(std::memory_order_acquire);
+        if (sequence != 0 && (sequence - 1) % header->capacity == slot)
+            valid.push_back({sequence, &records[slot]});
+    }
+    std::sort(valid.begin(), valid.end());
+
+    std::cout.precision(9);
+    if (!args.json)
+        printCsvHeader();
+    for (const auto& record : valid) {
+        if (args.json)
+            printJson(*record.second, args.landmarks);
+        else
+            printCsv(*record.second);
+    }
+
+    munmap(data, st.st_size);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,410 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "Alerts/AlertSinkStdout.h"
+#include "Capture/LoopSource.h"
+#include "Capture/ReplaySource.h"
+#include "Capture/VideoCaptureSource.h"
+#include "Pipeline.h"
+#include "Scheduler.h"
+#include "Utils.h"
+
+/**
+ * End-to-end benchmark of the raspidms pipeline, without camera nor display.
+ * Frames are served at a given rate by a LoopSource (frames of a video, recording or image,
+ * or synthetic noise frames), and go through the same stages, Scheduler and ThreadPool as in raspidms,
+ * for each face detector, face mesh and number of threads (0 : every stage on the capture thread, as without -j),
+ * fixed, or resized by the Scheduler between a minimum and a maximum (starting from the maximum).
+ *
+ * An observer thread takes the results out of the pipeline, as the display would, and measures :
+ * - the latency from capture to detection (rectsQueue), and to the complete results (faceFeaturesQueue,
+ *   every frame, with or without faces : synthetic frames have none)
+ * - the frames captured, detected, output, and dropped (captured but never output : frames skipped
+ *   by the detection interval still get results, they are not dropped)
+ * - the threads of the pool at the end, and the CPU time of the process relative to the duration
+ *
+ * One CSV line per configuration is written to the standard output. Everything else printed goes to the standard error.
+ */
+
+const int DEFAULT_SCHEDULER_THREAD_COUNTS[] = {0, DEFAULT_SCHEDULER_THREADS};
+const double DEFAULT_FPS = 30.;
+const double DEFAULT_DURATION = 10.;
+const double DEFAULT_WARMUP = 2.;
+const cv::Size DEFAULT_SYNTHETIC_SIZE(640, 480);
+
+// frames of a video kept in memory to be looped
+const int LOOP_MAX_FRAMES = 300;
+const int SYNTHETIC_FRAMES = 30;
+
+// observer polling period
+const double OBSERVER_PERIOD = 0.0005;
+
+void printHelp() {
+    std::cerr << "USAGE: " << std::endl
+    << "raspidms_pipeline_bench OPTIONS" << std::endl
+    << "with OPTIONS being ([] are optionals, rest is mandatory. A|B means A or B) :" << std::endl
+    << "    [-d|--face-detector NAME] (repeatable, mediapipe by default)" << std::endl
+    << "    [-m|--face-mesh NAME] (repeatable, mediapipe by default)" << std::endl
+    << "    [-t|--threads N] (repeatable, 0 and " << DEFAULT_SCHEDULER_THREADS << " by default)" << std::endl
+    << "    [-a|--adaptive MIN:MAX] (repeatable, pool resized between MIN and MAX threads)" << std::endl
+    << "    [-f|--fps FPS] (" << DEFAULT_FPS << " by default, 0 for as fast as possible)" << std::endl
+    << "    [-s|--seconds S] (" << DEFAULT_DURATION << " by default, after " << DEFAULT_WARMUP << " s of warmup)" << std::endl
+    << "    [-S|--size WIDTHxHEIGHT] (of synthetic frames, " << DEFAULT_SYNTHETIC_SIZE.width << "x"
+    << DEFAULT_SYNTHETIC_SIZE.height << " by default)" << std::endl
+    << "    [-h|--help]" << std::endl
+    << "    [PATH_TO_VIDEO.mp4|PATH_TO_RECORDING|PATH_TO_IMAGE] (synthetic frames if none)" << std::endl;
+}
+
+// a fixed number of threads (minThreads == maxThreads), or a range the pool is resized in
+struct ThreadConfig {
+    int minThreads;
+    int maxThreads;
+};
+
+struct Args {
+    std::vector<std::string> detectors;
+    std::vector<std::string> face_meshes;
+    std::vector<ThreadConfig> thread_configs;
+    std::string input_path;
+    double fps;
+    double duration;
+    cv::Size synthetic_size;
+};
+
+struct Args parseArgs(int argc, char** argv) {
+    struct Args args;
+    args.fps = DEFAULT_FPS;
+    args.duration = DEFAULT_DURATION;
+    args.synthetic_size = DEFAULT_SYNTHETIC_SIZE;
+
+    static struct option long_options[] = {
+    {"face-detector",  required_argument,  0,  'd' },
+    {"face-mesh",      required_argument,  0,  'm' },
+    {"threads",        required_argument,  0,  't' },
+    {"adaptive",       required_argument,  0,  'a' },
+    {"fps",            required_argument,  0,  'f' },
+    {"seconds",        required_argument,  0,  's' },
+    {"size",           required_argument,  0,  'S' },
+    {"help",           no_argument,        0,  'h' },
+    {0, 0, 0, 0},
+    };
+
+    int opt = 0;
+    int long_index = 0;
+    while ((opt = getopt_long(argc, argv, "d:m:t:a:f:s:S:h", long_options, &long_index)) != -1) {
+        switch (opt) {
+            case 'd' :
+                args.detectors.push_back(optarg);
+                break;
+            case 'm' :
+                args.face_meshes.push_back(optarg);
+                break;
+            case 't' : {
+                const int n_threads = std::min(MAX_STAGE_THREADS, std::max(0, atoi(optarg)));
+                args.thread_configs.push_back({n_threads, n_threads});
+                break;
+            }
+            case 'a' : {
+                ThreadConfig config;
+                if (sscanf(optarg, "%d:%d", &config.minThreads, &config.maxThreads) != 2
+                        || config.minThreads < 1 || config.maxThreads < config.minThreads
+                        || config.maxThreads > MAX_STAGE_THREADS) {
+                    printHelp();
+                    exit(EXIT_FAILURE);
+                }
+                args.thread_configs.push_back(config);
+                break;
+            }
+            case 'f' :
+                args.fps = std::max(0., atof(optarg));
+                break;
+            case 's' :
+                args.duration = std::max(0.1, atof(optarg));
+                break;
+            case 'S' :
+                if (sscanf(optarg, "%dx%d", &args.synthetic_size.width, &args.synthetic_size.height) != 2
+                        || args.synthetic_size.area() <= 0) {
+                    printHelp();
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'h':
+                printHelp();
+                exit(EXIT_SUCCESS);
+            default:
+                printHelp();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (optind < argc)
+        args.input_path = argv[optind];
+
+    if (args.detectors.empty())
+        args.detectors.push_back("mediapipe");
+    if (args.face_meshes.empty())
+        args.face_meshes.push_back("mediapipe");
+    if (args.thread_configs.empty()) {
+        for (int n_threads : DEFAULT_SCHEDULER_THREAD_COUNTS)
+            args.thread_configs.push_back({n_threads, n_threads});
+    }
+
+    return args;
+}
+
+static std::vector<cv::Mat> loadImages(const Args& args) {
+    std::vector<cv::Mat> images;
+
+    if (!args.input_path.empty()) {
+        std::unique_ptr<IFrameSource> source;
+        if (ReplaySource::isRecording(args.input_path))
+            source.reset(new ReplaySource(args.input_path, ReplayMode::MaxSpeed));
+        else
+            source.reset(new VideoCaptureSource(args.input_path));
+
+        Frame frame;
+        while (source->isOpened() && static_cast<int>(images.size()) < LOOP_MAX_FRAMES && source->read(frame))
+            images.push_back(frame.image.clone());
+
+        // a still image
+        if (images.empty()) {
+            cv::Mat image = cv::imread(args.input_path, cv::IMREAD_COLOR);
+            if (!image.empty())
+                images.push_back(image);
+        }
+
+        if (images.empty())
+            std::cerr << "Can't read " << args.input_path << std::endl;
+        return images;
+    }
+
+    // uniform noise, the same on every run
+    cv::RNG rng(0x5eed);
+    for (int i = 0; i < SYNTHETIC_FRAMES; ++i) {
+        cv::Mat image(args.synthetic_size, CV_8UC3);
+        rng.fill(image, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+        images.push_back(image);
+    }
+    return images;
+}
+
+/**
+ * @brief The OutputObserver class takes the results out of rectsQueue and faceFeaturesQueue,
+ * leaving the latest one in each (FaceFeaturesStage waits on rectsQueue), and keeps the capture to output
+ * latency of each frame the first time it comes out
+ */
+class OutputObserver
+{
+public:
+    OutputObserver(Pipeline& pipeline)
+        : m_pipeline(pipeline), m_stop(false), m_recording(false), m_thread(&OutputObserver::run, this) {}
+    OutputObserver(const OutputObserver&) = delete;
+
+    ~OutputObserver() {
+        m_stop = true;
+        m_thread.join();
+    }
+
+    // only record the latencies from now on
+    void startRecording() { m_recording = true; }
+
+    struct Output {
+        long newestId = -1;
+        long count = 0;
+        std::vector<double> latencies;
+    };
+
+    // results out of rectsQueue, and out of faceFeaturesQueue
+    void take(Output& detections, Output& results) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        detections = m_detections;
+        results = m_results;
+    }
+
+private:
+    void run() {
+        while (!m_stop) {
+            {
+                std::lock_guard<std::mutex> guard(m_mutex);
+                observe(*m_pipeline.rectsQueue, m_detections);
+                observe(*m_pipeline.faceFeaturesQueue, m_results);
+            }
+            std::this_thread::sleep_for(std::chrono::duration<double>(OBSERVER_PERIOD));
+        }
+    }
+
+    void observe(SharedQueue<FaceResultsPtr>& queue, Output& output) {
+        FaceResultsPtr faces;
+        while (queue.size() > 1 && queue.pop_front_no_wait(faces))
+            record(*faces, output);
+        if (queue.front_no_wait(faces))
+            record(*faces, output);
+    }
+
+    void record(const FaceResults& faces, Output& output) {
+        // frames are processed again while no newer one comes in
+        if (faces.frame.id <= output.newestId)
+            return;
+        output.newestId = faces.frame.id;
+        if (!m_recording)
+            return;
+        ++output.count;
+        output.latencies.push_back(timeNow() - faces.frame.timestamp);
+    }
+
+    Pipeline& m_pipeline;
+    Output m_detections;
+    Output m_results;
+    std::mutex m_mutex;
+    std::atomic<bool> m_stop;
+    std::atomic<bool> m_recording;
+    std::thread m_thread;
+};
+
+// CPU time used by all the threads of the process so far, in seconds
+static double processCpuTime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void printHeader(FILE* table) {
+    fprintf(table, "detector,mesh,threads,final_threads,cpu_percent,target_fps,duration_s,captured,detected,dropped,output_frames,"
+                   "capture_fps,detect_fps,output_fps,detect_latency_p50_ms,detect_latency_p99_ms,"
+                   "latency_p50_ms,latency_p99_ms\n");
+}
+
+static void runConfiguration(FILE* table, const std::vector<cv::Mat>& images, const Args& args,
+                             const std::string& detector, const std::string& mesh, const ThreadConfig& threads) {
+    const bool adaptive = threads.minThreads != threads.maxThreads;
+    const std::string threads_name = adaptive ? std::to_string(threads.minThreads) + "-" + std::to_string(threads.maxThreads)
+                                              : std::to_string(threads.maxThreads);
+    std::cerr << "Benchmarking " << detector << " / " << mesh << " / " << threads_name << " threads" << std::endl;
+
+    Pipeline pipeline(detector, mesh, std::string(), 0, std::make_shared<AlertSinkStdout>(std::cerr));
+
+    std::unique_ptr<Scheduler> scheduler;
+    if (threads.maxThreads > 0) {
+        scheduler.reset(new Scheduler(threads.maxThreads));
+        scheduler->addFunc([&](int threadId) {
+            pipeline.runStages(threadId);
+        });
+        scheduler->setThreadRetiredCb([&](int threadId) {
+            pipeline.releaseThread(threadId);
+        });
+        if (adaptive) {
+            scheduler->setAutoResize(threads.minThreads, threads.maxThreads, [&]() {
+                return pipeline.inputFrameQueue->size_no_lock();
+            });
+        }
+    }
+
+    // as raspidms : models loaded and warmed up before the first frame
+    std::vector<int> thread_ids;
+    for (int thread_id = 0; thread_id < std::max(1, threads.maxThreads); ++thread_id)
+        thread_ids.push_back(thread_id);
+    pipeline.preload(thread_ids, std::cerr);
+
+    OutputObserver observer(pipeline);
+    LoopSource source(images, args.fps);
+
+    long captured = 0;
+    long captured_at_start = 0;
+    long detected_at_start = 0;
+    double start_time = 0.;
+    double start_cpu_time = 0.;
+    const double warmup_end = timeNow() + DEFAULT_WARMUP;
+    bool recording = false;
+    for (;;) {
+        const double now = timeNow();
+        if (!recording && now >= warmup_end) {
+            recording = true;
+            observer.startRecording();
+            captured_at_start = captured;
+            detected_at_start = pipeline.detectFacesStage.detectedFrames();
+            start_time = now;
+            start_cpu_time = processCpuTime();
+        }
+        if (recording && now - start_time >= args.duration)
+            break;
+
+        // as raspidms : lose frames if too slow
+        while (pipeline.inputFrameQueue->size() > MAX_IN_BUFFER_SIZE)
+            pipeline.inputFrameQueue->pop_front_no_wait();
+
+        Frame frame;
+        if (!source.read(frame))
+            break;
+        ++captured;
+        pipeline.inputFrameQueue->push_back(frame);
+
+        if (scheduler)
+            scheduler->schedule();
+        else
+            pipeline.runStages(0);
+    }
+
+    const double elapsed = timeNow() - start_time;
+    const double cpu_time = processCpuTime() - start_cpu_time;
+    const int final_threads = scheduler ? scheduler->threadCount() : 0;
+    const long n_captured = captured - captured_at_start;
+    const long n_detected = pipeline.detectFacesStage.detectedFrames() - detected_at_start;
+
+    OutputObserver::Output detections;
+    OutputObserver::Output results;
+    observer.take(detections, results);
+
+    fprintf(table, "%s,%s,%s,%d,%.1f,%.1f,%.2f,%ld,%ld,%ld,%ld,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+            detector.c_str(), mesh.c_str(), threads_name.c_str(), final_threads, cpu_time * 100. / elapsed,
+            args.fps, elapsed,
+            n_captured, n_detected, std::max(0L, n_captured - results.count), results.count,
+            n_captured / elapsed, n_detected / elapsed, results.count / elapsed,
+            percentile(detections.latencies, 50.) * 1000., percentile(detections.latencies, 99.) * 1000.,
+            percentile(results.latencies, 50.) * 1000., percentile(results.latencies, 99.) * 1000.);
+    fflush(table);
+
+    // the scheduler threads stop before the pipeline they run is destroyed
+    scheduler.reset();
+}
+
+int main(int argc, char** argv) {
+    const struct Args args = parseArgs(argc, argv);
+
+    // the table keeps the standard output, stages and models print their own messages to the standard error
+    FILE* table = fdopen(dup(STDOUT_FILENO), "w");
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    if (!table) {
+        std::cerr << "Can't open the standard output" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<cv::Mat> images = loadImages(args);
+    if (images.empty())
+        return EXIT_FAILURE;
+
+    printHeader(table);
+    for (const std::string& detector : args.detectors) {
+        for (const std::string& mesh : args.face_meshes) {
+            for (const ThreadConfig& threads : args.thread_configs)
+                runConfiguration(table, images, args, detector, mesh, threads);
+        }
+    }
+
+    fclose(table);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Publish/ShmFormat.h"
+
+/**
+ * Minimal reader of the shared memory published by raspidms in headless mode (-H option)
+ * Prints a line per new frame : frame id, size, faces, driver state and the latency since capture.
+ * The frame pixels are copied to a local buffer, as a real consumer would (e.g. wrapped into a cv::Mat).
+ */
+
+// polling period when there is no new frame
+const useconds_t POLL_PERIOD_US = 2000;
+
+// same time base as timeNow() in raspidms (cv::getTickCount is CLOCK_MONOTONIC on Linux)
+static double monotonicNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief readLatest copy the latest slot (header and pixels) to slotCopy, retrying while the publisher writes it
+ * @return false if nothing was published yet
+ */
+static bool readLatest(const ShmHeader* header, std::vector<char>& slotCopy) {
+    const char* slots = reinterpret_cast<const char*>(header) + header->slotsOffset;
+    for (;;) {
+        const uint32_t latest = header->latest.load(std::memory_order_acquire);
+        if (latest >= header->numSlots)
+            return false;
+
+        const char* slot_data = slots + latest * header->slotSize;
+        const ShmSlotHeader* slot = reinterpret_cast<const ShmSlotHeader*>(slot_data);
+
+        const uint64_t before = slot->sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            continue;
+
+        const ShmSlotHeader* copy = reinterpret_cast<const ShmSlotHeader*>(slotCopy.data());
+        std::memcpy(slotCopy.data(), slot_data, sizeof(ShmSlotHeader));
+        const size_t frame_bytes = static_cast<size_t>(copy->step) * copy->height;
+        if (frame_bytes <= header->maxFrameBytes)
+            std::memcpy(slotCopy.data() + header->frameOffset, slot_data + header->frameOffset, frame_bytes);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) == before && frame_bytes <= header->maxFrameBytes)
+            return true;
+    }
+}
+
+/**
+ * @brief mapHeader map the segment, once its header is complete
+ * (the publisher creates the segment, sizes it, and then writes its header)
+ * @param name
+ * @param mappedSize
+ * @return the header, null if the segment does not exist yet, or is not complete
+ */
+static const ShmHeader* mapHeader(const std::string& name, size_t& mappedSize) {
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ShmHeader)) {
+        close(fd);
+        return nullptr;
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return nullptr;
+
+    const ShmHeader* header = static_cast<const ShmHeader*>(data);
+    if (header->magic.load(std::memory_order_acquire) != shmMagic()) {
+        munmap(data, st.st_size);
+        return nullptr;
+    }
+
+    mappedSize = st.st_size;
+    return header;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 2 || (argc == 2 && std::string(argv[1]) == "-h")) {
+        std::cout << "USAGE: raspidms_shm_reader [SHM_NAME]  (default " << SHM_DEFAULT_NAME << ")" << std::endl;
+        return argc == 2 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    const std::string name = argc == 2 ? argv[1] : SHM_DEFAULT_NAME;
+
+    // the segment is created by raspidms on its first frame, wait for it to be complete
+    size_t mapped_size = 0;
+    const ShmHeader* header = nullptr;
+    while (!(header = mapHeader(name, mapped_size)))
+        usleep(100 * POLL_PERIOD_US);
+
+    if (header->version != SHM_VERSION
+            || header->slotsOffset + static_cast<uint64_t>(header->numSlots) * header->slotSize > mapped_size) {
+        std::cerr << "Not a raspidms shared memory, or another version " << name << std::endl;
+        munmap(const_cast<ShmHeader*>(header), mapped_size);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<char> slot_copy(header->slotSize);
+    const ShmSlotHeader* slot = reinterpret_cast<const ShmSlotHeader*>(slot_copy.data());
+    int64_t last_frame_id = -1;
+
+    for (;;) {
+        if (!readLatest(header, slot_copy) || slot->frameId == last_frame_id) {
+            usleep(POLL_PERIOD_US);
+            continue;
+        }
+        last_frame_id = slot->frameId;
+
+        const double latency_ms = (monotonicNow() - slot->frameTimestamp) * 1000.;
+        std::cout << "frame " << slot->frameId << " " << slot->width << "x" << slot->height
+                  << " latency " << latency_ms << " ms";
+        if (slot->hasResults) {
+            const FrameLogRecord& results = slot->results;
+            std::cout << " | results of frame " << results.frameId << ", " << results.numFaces << " faces";
+            if (results.driverValid)
+                std::cout << ", EAR " << results.eyeAspectRatio << (results.eyesClosed ? " eyes closed" : "")
+                          << ", PERCLOS " << results.perclos;
+        }
+        std::cout << std::endl;
+    }
+
+    return 0;
+}